@@ -1,6 +1,8 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_NeoPixel.h>
 #include <irm_mini.h>
+#include <irm_clock.h>
+#include <irm_weather.h>
 #include <WiFi.h>
 #include "time.h"
 #include "sntp.h"
@@ -33,7 +35,9 @@ const int   daylightOffset_sec = 0;
 String weatherUrl = String("https://api.openweathermap.org/data/2.5/weather?q=") + \
   WEATHER_CITY_NAME + "&appid=" + WEATHER_API_KEY + "&units=" + WEATHER_UNITS;
 
-uint16_t millisCounter = 0;
+// Weather is fetched between frames instead of behind a delay()
+#define WEATHER_INTERVAL_MS 60000
+uint32_t lastWeatherMillis = 0;
 
 // Define full matrix width and height.
 #define mw TILE_WIDTH * 8
@@ -46,11 +50,32 @@ IRM_Mini *matrix = new IRM_Mini(
   NEO_TILE_ROWS   + NEO_TILE_ZIGZAG,
   NEO_RGB         + NEO_KHZ800 );
 
+// Drawn by the matrix frame clock, see matrix->tick() in loop(). The
+// clock keeps time between syncs and only redraws digits that change.
+IRM_ClockWidget clockFace;
+#define TIME_SYNC_MS 60000
+uint32_t lastSyncMillis = 0;
+
+// Fed straight from the HTTP response, see testWeather()
+IRM_WeatherWidget weather;
+
+// All library buffers come from here, so the heap doesn't fragment over
+// weeks of uptime. Check the printed high-water mark to size it.
+static uint8_t matrixArena[4096];
+
 void setup() {
   Serial.begin(115200);
-  matrix->begin();
+  matrix->begin(matrixArena, sizeof(matrixArena));
   matrix->setTextWrap(false);
   matrix->setBrightness(BRIGHTNESS);
+  matrix->setFrameRate(2); // For the blinking colon
+  matrix->fillScreen(GREY);
+  clockFace.setPosition(mw - 22, 0, WHITE, GREY, FONT5); // HH:MM is 22 wide
+  clockFace.setOptions(false, true);
+  matrix->addWidget(&clockFace);
+  weather.setIcons(&WEATHER_ICONS[0][0], 16, 16);
+  weather.setPosition(0, 0, WHITE, GREY);
+  matrix->addWidget(&weather);
   
   sntp_servermode_dhcp(1);    // (optional)
   sntp_setservername(0, ntpServer1);
@@ -62,47 +87,36 @@ void setup() {
     Serial.print(".");
   }
   Serial.println(" CONNECTED");
+  Serial.printf("Matrix arena: %u of %u bytes\n",
+                (unsigned)matrix->arenaHighWater(), (unsigned)matrix->arenaSize());
 
 }
 
 void loop() {
-  // matrix->clear();
-  matrix->fillScreen(GREY);
-  // drawTime();
-  // testIcon();
-  testWeather();
-  matrix->show();
-  delay(5000);
-  // if ((millis() - millisCounter) % 1000 == 0) {
-  //   drawTime();
-  // }
-  // if (millis() - millisCounter % 5000 == 0) {
-  //   drawWeather();
-  //   millisCounter = millis();
-  // }
+  if (!clockFace.valid() || (millis() - lastSyncMillis >= TIME_SYNC_MS))
+    syncTime();
+  matrix->tick(millis());
+  if (millis() - lastWeatherMillis >= WEATHER_INTERVAL_MS) {
+    lastWeatherMillis = millis();
+    testWeather();
+  }
 }
 
-void drawTime() {
+void syncTime() {
   struct tm timeinfo;
-  if(!getLocalTime(&timeinfo)){
-    Serial.println("No time available (yet)");
-    return;
+  if(!getLocalTime(&timeinfo, 0)){
+    return; // No time available (yet)
   }
+  lastSyncMillis = millis();
   Serial.println(&timeinfo, "%A, %B %d %Y %H:%M:%S");
-  String timeStr;
-  String hour = String(timeinfo.tm_hour);
-  if (hour.length() == 1) hour = "0" + hour;
-  String minute = String(timeinfo.tm_min);
-  if (minute.length() == 1) minute = "0" + minute;
-  timeStr = hour + ":" + minute;
-  matrix->drawAscii(48-19, 0, timeStr, WHITE, FONT5);
+  clockFace.setTime(timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
 }
 
 void testIcon() {
   for (uint i=0; i<=16; i++) {
   matrix->fillScreen(GREY);
     matrix->drawRGBBitmap(0, 0, WEATHER_ICONS[i], 16, 16);
-    Serial.println(WEATHER_ICON_LABLES[i]);
+    Serial.println(i);
     delay(1000);
     matrix->show();
   }
@@ -132,8 +146,11 @@ void testWeather() {
 
       // file found at server
       if(httpCode == HTTP_CODE_OK) {
-          String payload = http.getString();
-          Serial.println(payload);
+          // Parsed as it arrives, the body is never buffered
+          weather.begin();
+          http.writeToStream(&weather);
+          Serial.printf("[HTTP] temp %d.%d, icon %d\n", weather.temperature() / 10,
+                        abs(weather.temperature() % 10), weather.icon());
       }
   } else {
       Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
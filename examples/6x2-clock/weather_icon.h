@@ -1,25 +1,7 @@
 #include "Arduino.h"
 
-String WEATHER_ICON_LABLES[] = {
-  "01D",
-  "01N",
-  "02D",
-  "02N",
-  "03D",
-  "03N",
-  "04D",
-  "04N",
-  "09D",
-  "09N",
-  "10D",
-  "10N",
-  "11D",
-  "11N",
-  "13D",
-  "13N",
-  "50D",
-};
-
+// Icons in IRM_WeatherWidget::iconIndex() order: 01D, 01N, 02D, 02N, 03D,
+// 03N, 04D, 04N, 09D, 09N, 10D, 10N, 11D, 11N, 13D, 13N, 50D
 static const uint32_t PROGMEM WEATHER_ICONS[][256] = {
   { // WEATHER_SPRITE_01D
     0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,  
@@ -1,6 +1,7 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_NeoPixel.h>
 #include <irm_mini.h>
+#include <irm_sprite.h>
 
 // Choose your prefered pixmap
 //#include "heart24.h"
@@ -244,10 +245,13 @@ static const uint16_t PROGMEM
 
 
 // Convert a BGR 4/4/4 bitmap to RGB 5/6/5 used by Adafruit_GFX
-void fixdrawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h) {
+const uint16_t *fixRGBBitmap(const uint16_t *bitmap, int16_t w, int16_t h) {
     // work around "a15 cannot be used in asm here" compiler bug when using an array on ESP8266
     // uint16_t RGB_bmp_fixed[w * h];
-    static uint16_t *RGB_bmp_fixed = (uint16_t *) malloc( w*h*2);
+    // Static rather than malloc'd so long runs don't fragment the heap;
+    // all the RGB_bmp pixmaps are 8x8.
+    static uint16_t RGB_bmp_fixed[8 * 8];
+    if (w * h > 8 * 8) return NULL;
     for (uint16_t pixel=0; pixel<w*h; pixel++) {
     uint8_t r,g,b;
     uint16_t color = pgm_read_word(bitmap + pixel);
@@ -276,7 +280,12 @@ void fixdrawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, i
     //Serial.print(" -> ");
     //Serial.println(RGB_bmp_fixed[pixel], HEX);
     }
-    matrix->drawRGBBitmap(x, y, RGB_bmp_fixed, w, h);
+    return RGB_bmp_fixed;
+}
+
+void fixdrawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h) {
+    const uint16_t *fixed = fixRGBBitmap(bitmap, w, h);
+    if (fixed) matrix->drawRGBBitmap(x, y, fixed, w, h);
 }
 
 // In a case of a tile of neomatrices, this test is helpful to make sure that the
@@ -472,69 +481,37 @@ void display_scrollText() {
 // If the bitmap is bigger in one dimension and smaller in the other one, it will
 // be both panned and bounced in the appropriate dimensions.
 void display_panOrBounceBitmap (uint8_t bitmapSize) {
-    // keep integer math, deal with values 16 times too big
+    // The bitmap is a sprite, so each step only redraws the pixels it
+    // uncovered or now covers instead of clearing the whole screen.
+    const uint16_t *bitmap = (const uint16_t *) bitmap24;
+    // bounce 8x8 tri color smiley face around the screen; the fixed-up
+    // copy is in RAM, the big bitmaps are in PROGMEM
+    bool progmem = true;
+    if (bitmapSize == 8) {
+        bitmap = fixRGBBitmap(RGB_bmp[10], 8, 8);
+        progmem = false;
+    }
+#ifdef BM32
+    if (bitmapSize == 32) bitmap = (const uint16_t *) bitmap32;
+#endif
+    IRM_SpriteLayer layer(*matrix);
+    IRM_Sprite sprite(bitmap, IRM_SPRITE_RGB565, bitmapSize, bitmapSize,
+                      NULL, progmem);
+    sprite.setOpaque();
+    layer.add(&sprite);
+
     // start by showing upper left of big bitmap or centering if the display is big
-    int16_t xf = max(0, (mw-bitmapSize)/2) << 4;
-    int16_t yf = max(0, (mh-bitmapSize)/2) << 4;
-    // scroll speed in 1/16th
-    int16_t xfc = 6;
-    int16_t yfc = 3;
-    // scroll down and right by moving upper left corner off screen 
-    // more up and left (which means negative numbers)
-    int16_t xfdir = -1;
-    int16_t yfdir = -1;
+    sprite.moveTo(max(0, (mw-bitmapSize)/2), max(0, (mh-bitmapSize)/2));
+    // Pixmaps bigger than the display pan across it, smaller ones bounce
+    // off the 'walls'. Speeds are in 1/16th pixel per second.
+    sprite.setVelocity(-600, -300);
+    sprite.setBounce(true);
 
     for (uint16_t i=1; i<200; i++) {
-    bool updDir = false;
-
-    // Get actual x/y by dividing by 16.
-    int16_t x = xf >> 4;
-    int16_t y = yf >> 4;
-
-    matrix->clear();
-    // bounce 8x8 tri color smiley face around the screen
-    if (bitmapSize == 8) fixdrawRGBBitmap(x, y, RGB_bmp[10], 8, 8);
-    // pan 24x24 pixmap
-    if (bitmapSize == 24) matrix->drawRGBBitmap(x, y, (const uint16_t *) bitmap24, bitmapSize, bitmapSize);
-#ifdef BM32
-    if (bitmapSize == 32) matrix->drawRGBBitmap(x, y, (const uint16_t *) bitmap32, bitmapSize, bitmapSize);
-#endif
-    matrix->show();
-     
-    // Only pan if the display size is smaller than the pixmap
-    // but not if the difference is too small or it'll look bad.
-    if (bitmapSize-mw>2) {
-        xf += xfc*xfdir;
-        if (xf >= 0)                      { xfdir = -1; updDir = true ; };
-        // we don't go negative past right corner, go back positive
-        if (xf <= ((mw-bitmapSize) << 4)) { xfdir = 1;  updDir = true ; };
-    }
-    if (bitmapSize-mh>2) {
-        yf += yfc*yfdir;
-        // we shouldn't display past left corner, reverse direction.
-        if (yf >= 0)                      { yfdir = -1; updDir = true ; };
-        if (yf <= ((mh-bitmapSize) << 4)) { yfdir = 1;  updDir = true ; };
-    }
-    // only bounce a pixmap if it's smaller than the display size
-    if (mw>bitmapSize) {
-        xf += xfc*xfdir;
-        // Deal with bouncing off the 'walls'
-        if (xf >= (mw-bitmapSize) << 4) { xfdir = -1; updDir = true ; };
-        if (xf <= 0)           { xfdir =  1; updDir = true ; };
-    }
-    if (mh>bitmapSize) {
-        yf += yfc*yfdir;
-        if (yf >= (mh-bitmapSize) << 4) { yfdir = -1; updDir = true ; };
-        if (yf <= 0)           { yfdir =  1; updDir = true ; };
-    }
-    
-    if (updDir) {
-        // Add -1, 0 or 1 but bind result to 1 to 1.
-        // Let's take 3 is a minimum speed, otherwise it's too slow.
-        xfc = constrain(xfc + random(-1, 2), 3, 16);
-        yfc = constrain(xfc + random(-1, 2), 3, 16);
-    }
-    delay(10);
+        layer.update(10);
+        layer.render(*matrix);
+        matrix->show();
+        delay(10);
     }
 }
 
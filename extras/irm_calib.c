@@ -0,0 +1,96 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  It's a
+// command-line tool that turns brightness measurements of each tile (or
+// LED) into a calibration table for IRM_Mini::setCalibration(); the table
+// goes to stdout, redirect it into a header file for your sketch.
+//
+// Input, from a file or stdin: one line per tile (or LED), in chain order,
+// "index red green blue", the measured light output of each channel at full
+// drive (any unit, e.g. a lux meter or camera pixel values). Lines starting
+// with # are ignored. Every channel is scaled down to match the dimmest
+// entry, so all tiles look alike.
+//
+// Usage: irm_calib [-n name] [measurements.txt]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ENTRIES 4096
+
+double level[MAX_ENTRIES][3];
+
+int main(int argc, char *argv[]) {
+  const char *name = "calibration";
+  FILE *in = stdin;
+  char line[256];
+  double target[3] = {0, 0, 0};
+  int i, c, count = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+      name = argv[++i];
+    } else if (!(in = fopen(argv[i], "r"))) {
+      perror(argv[i]);
+      return 1;
+    }
+  }
+
+  while (fgets(line, sizeof(line), in)) {
+    int idx;
+    double r, g, b;
+    if ((line[0] == '#') ||
+        (sscanf(line, "%d %lf %lf %lf", &idx, &r, &g, &b) != 4))
+      continue;
+    if ((idx < 0) || (idx >= MAX_ENTRIES) || (r <= 0) || (g <= 0) || (b <= 0)) {
+      fprintf(stderr, "bad entry: %s", line);
+      return 1;
+    }
+    level[idx][0] = r;
+    level[idx][1] = g;
+    level[idx][2] = b;
+    if (idx >= count)
+      count = idx + 1;
+  }
+  if (!count) {
+    fprintf(stderr, "no measurements\n");
+    return 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (level[i][0] <= 0) {
+      fprintf(stderr, "entry %d missing\n", i);
+      return 1;
+    }
+    for (c = 0; c < 3; c++)
+      if ((target[c] == 0) || (level[i][c] < target[c]))
+        target[c] = level[i][c];
+  }
+
+  (void)printf("#ifdef __AVR\n"
+               " #include <avr/pgmspace.h>\n"
+               "#else\n"
+               " #ifndef PROGMEM\n"
+               "  #define PROGMEM\n"
+               " #endif\n"
+               "#endif\n"
+               "\n"
+               "// %d entries, R G B; 255 = unchanged\n"
+               "static const uint8_t PROGMEM\n"
+               "  %s[] = {\n",
+               count, name);
+
+  for (i = 0; i < count; i++) {
+    (void)printf("    ");
+    for (c = 0; c < 3; c++) {
+      // IRM_Mini scales by (gain + 1) / 256
+      int gain = (int)(256.0 * target[c] / level[i][c] + 0.5) - 1;
+      (void)printf("%3d%s", (gain < 0) ? 0 : (gain > 255) ? 255 : gain,
+                   ((i < count - 1) || (c < 2)) ? "," : "");
+    }
+    (void)printf("\n");
+  }
+
+  (void)puts("};");
+
+  return 0;
+}
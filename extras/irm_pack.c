@@ -0,0 +1,310 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  It's a
+// command-line tool that builds an asset pack for IRM_AssetPack (see
+// irm_asset.h) from image files.  The pack is written as a binary, to flash
+// to a data partition or copy to a file system, or with -c as a C header
+// holding a PROGMEM array.
+//
+// Each asset is given as name=file[,frames=N][,font=C]:
+//   file.qoi   stored as is (IRM_ASSET_QOI)
+//   file.ppm   binary PPM (P6), converted to '565' (IRM_ASSET_RGB565)
+//   file.pbm   binary PBM (P4), 1-bit (IRM_ASSET_MONO); with font=C, the
+//              frames are glyphs for characters C, C + 1, ... and each
+//              glyph's width is measured from its pixels (IRM_ASSET_FONT)
+//   other      stored as is (IRM_ASSET_RAW)
+// frames=N splits an image into N frames stacked top to bottom, e.g. an
+// animation strip or a font sheet.  C is a character or a decimal code.
+//
+// Usage: irm_pack [-c symbol] -o pack.bin asset...
+//
+// Example, packing an icon, an 8-frame animation strip and a font sheet of
+// 95 glyphs from ' ', then flashing it to an ESP32 "assets" partition:
+//   irm_pack -o assets.bin sun=sun.qoi rain=rain.ppm,frames=8
+//            small=font.pbm,frames=95,font=32
+//   parttool.py write_partition --partition-name assets --input assets.bin
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FORMAT_RAW 0
+#define FORMAT_RGB565 1
+#define FORMAT_MONO 2
+#define FORMAT_FONT 3
+#define FORMAT_QOI 4
+
+#define HEADER 12
+#define ENTRY 20
+#define MAX_ASSETS 65535
+
+typedef struct {
+  const char *name;
+  uint32_t hash, offset, size;
+  uint16_t w, h, frames;
+  uint8_t format, base;
+  uint8_t *data;
+} Asset;
+
+static Asset assets[MAX_ASSETS];
+static int count;
+
+// Must match IRM_AssetPack::hash()
+static uint32_t fnv1a(const char *s) {
+  uint32_t h = 2166136261u;
+  while (*s) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static uint8_t *slurp(const char *path, uint32_t *len) {
+  FILE *f = fopen(path, "rb");
+  uint8_t *buf = NULL;
+  size_t cap = 0, n = 0, r;
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  do {
+    if (n == cap) {
+      cap = cap ? cap * 2 : 65536;
+      if (!(buf = realloc(buf, cap))) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+      }
+    }
+    r = fread(buf + n, 1, cap - n, f);
+    n += r;
+  } while (r);
+  fclose(f);
+  *len = n;
+  return buf;
+}
+
+// Parse a binary PNM header ("P6 w h 255\n" or "P4 w h\n"), comments
+// allowed; returns the offset of the pixel data
+static uint32_t pnmHeader(const uint8_t *p, uint32_t len, int fields,
+                          int *val) {
+  uint32_t i = 2;
+  int f;
+  for (f = 0; f < fields; f++) {
+    while ((i < len) && ((p[i] == '#') || (p[i] <= ' '))) {
+      if (p[i] == '#')
+        while ((i < len) && (p[i] != '\n'))
+          i++;
+      i++;
+    }
+    val[f] = 0;
+    while ((i < len) && (p[i] >= '0') && (p[i] <= '9'))
+      val[f] = val[f] * 10 + (p[i++] - '0');
+  }
+  return i + 1; // Single whitespace byte before the data
+}
+
+static void load(Asset *a, const char *path, int frames, int font) {
+  uint32_t len, start, x, y;
+  uint8_t *raw = slurp(path, &len);
+  int v[3];
+
+  a->frames = 1;
+  if ((len >= 14) && !memcmp(raw, "qoif", 4)) {
+    a->format = FORMAT_QOI;
+    a->w = (raw[6] << 8) | raw[7];
+    a->h = (raw[10] << 8) | raw[11];
+    a->data = raw;
+    a->size = len;
+    return;
+  }
+  if ((len < 3) || (raw[0] != 'P') || ((raw[1] != '6') && (raw[1] != '4'))) {
+    a->format = FORMAT_RAW;
+    a->data = raw;
+    a->size = len;
+    return;
+  }
+
+  start = pnmHeader(raw, len, (raw[1] == '6') ? 3 : 2, v);
+  if ((v[0] < 1) || (v[0] > 65535) || (v[1] < 1) || (v[1] % frames)) {
+    fprintf(stderr, "%s: bad size, or height not a multiple of %d\n", path,
+            frames);
+    exit(1);
+  }
+  a->w = v[0];
+  a->h = v[1] / frames;
+  a->frames = frames;
+
+  if (raw[1] == '6') {
+    if ((v[2] != 255) || (len < start + (uint32_t)v[0] * v[1] * 3)) {
+      fprintf(stderr, "%s: need an 8-bit P6 file\n", path);
+      exit(1);
+    }
+    a->format = FORMAT_RGB565;
+    a->size = (uint32_t)v[0] * v[1] * 2;
+    a->data = malloc(a->size);
+    for (x = 0; x < (uint32_t)v[0] * v[1]; x++) {
+      const uint8_t *c = &raw[start + x * 3];
+      uint16_t p = ((c[0] & 0xF8) << 8) | ((c[1] & 0xFC) << 3) | (c[2] >> 3);
+      a->data[x * 2] = p;
+      a->data[x * 2 + 1] = p >> 8;
+    }
+  } else {
+    uint32_t stride = (v[0] + 7) / 8, cell = stride * a->h;
+    if ((stride > 32) || (len < start + stride * v[1])) {
+      fprintf(stderr, "%s: truncated, or wider than 256\n", path);
+      exit(1);
+    }
+    if (font < 0) {
+      a->format = FORMAT_MONO;
+      a->size = stride * v[1];
+      a->data = malloc(a->size);
+      memcpy(a->data, &raw[start], a->size);
+    } else {
+      int f;
+      if ((a->w > 255) || (font + frames > 256)) {
+        fprintf(stderr, "%s: font too wide, or too many glyphs\n", path);
+        exit(1);
+      }
+      a->format = FORMAT_FONT;
+      a->base = font;
+      a->size = (1 + cell) * frames;
+      a->data = malloc(a->size);
+      for (f = 0; f < frames; f++) {
+        const uint8_t *g = &raw[start + f * cell];
+        uint8_t *d = &a->data[f * (1 + cell)];
+        int width = 0;
+        for (y = 0; y < a->h; y++)
+          for (x = 0; x < a->w; x++)
+            if ((g[y * stride + x / 8] & (0x80 >> (x & 7))) &&
+                ((int)x >= width))
+              width = x + 1;
+        d[0] = width ? width : (a->w + 1) / 2; // Blank glyphs: a space
+        memcpy(d + 1, g, cell);
+      }
+    }
+  }
+  free(raw);
+}
+
+static int byHash(const void *a, const void *b) {
+  uint32_t x = ((const Asset *)a)->hash, y = ((const Asset *)b)->hash;
+  return (x > y) - (x < y);
+}
+
+static void put16(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+int main(int argc, char *argv[]) {
+  const char *out = NULL, *symbol = NULL;
+  uint32_t total, i;
+  uint8_t *pack;
+  FILE *f;
+  int a;
+
+  for (a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "-o") && (a + 1 < argc)) {
+      out = argv[++a];
+    } else if (!strcmp(argv[a], "-c") && (a + 1 < argc)) {
+      symbol = argv[++a];
+    } else {
+      char *eq = strchr(argv[a], '='), *opt;
+      int frames = 1, font = -1;
+      if (!eq || (eq == argv[a]) || (count == MAX_ASSETS)) {
+        fprintf(stderr, "bad asset \"%s\", expected name=file\n", argv[a]);
+        return 1;
+      }
+      *eq = 0;
+      if ((opt = strchr(eq + 1, ','))) {
+        *opt++ = 0;
+        for (opt = strtok(opt, ","); opt; opt = strtok(NULL, ",")) {
+          if (!strncmp(opt, "frames=", 7)) {
+            frames = atoi(opt + 7);
+          } else if (!strncmp(opt, "font=", 5)) {
+            font = ((opt[5] >= '0') && (opt[5] <= '9') && opt[6])
+                       ? atoi(opt + 5)
+                       : (uint8_t)opt[5];
+          } else {
+            fprintf(stderr, "unknown option \"%s\"\n", opt);
+            return 1;
+          }
+        }
+      }
+      if ((frames < 1) || (frames > 65535) || (font > 255)) {
+        fprintf(stderr, "%s: bad frames or font\n", argv[a]);
+        return 1;
+      }
+      assets[count].name = argv[a];
+      assets[count].hash = fnv1a(argv[a]);
+      load(&assets[count], eq + 1, frames, font);
+      count++;
+    }
+  }
+  if (!out || !count) {
+    fprintf(stderr,
+            "usage: irm_pack [-c symbol] -o pack.bin name=file[,frames=N]"
+            "[,font=C]...\n");
+    return 1;
+  }
+
+  qsort(assets, count, sizeof(Asset), byHash);
+  total = HEADER + count * ENTRY;
+  for (a = 0; a < count; a++) {
+    if (a && (assets[a].hash == assets[a - 1].hash)) {
+      fprintf(stderr, "\"%s\" and \"%s\" have the same hash; rename one\n",
+              assets[a - 1].name, assets[a].name);
+      return 1;
+    }
+    total = (total + 3) & ~3u;
+    assets[a].offset = total;
+    total += assets[a].size;
+  }
+
+  pack = calloc(1, total);
+  memcpy(pack, "IRMA", 4);
+  pack[4] = 1; // IRM_ASSET_VERSION
+  put16(&pack[6], count);
+  put32(&pack[8], total);
+  for (a = 0; a < count; a++) {
+    uint8_t *e = &pack[HEADER + a * ENTRY];
+    put32(e, assets[a].hash);
+    put32(e + 4, assets[a].offset);
+    put32(e + 8, assets[a].size);
+    put16(e + 12, assets[a].w);
+    put16(e + 14, assets[a].h);
+    put16(e + 16, assets[a].frames);
+    e[18] = assets[a].format;
+    e[19] = assets[a].base;
+    memcpy(&pack[assets[a].offset], assets[a].data, assets[a].size);
+  }
+
+  if (!(f = fopen(out, symbol ? "w" : "wb"))) {
+    perror(out);
+    return 1;
+  }
+  if (symbol) {
+    // Aligned so that where PROGMEM is addressable (ESP32, ARM) the array
+    // can be given to begin() with progmem = false and drawn in place
+    fprintf(f, "// Asset pack: %d assets, %u bytes\n", count, total);
+    fprintf(f, "static const uint8_t %s[] PROGMEM __attribute__((aligned(4)))"
+               " = {",
+            symbol);
+    for (i = 0; i < total; i++)
+      fprintf(f, "%s0x%02X,", (i % 16) ? "" : "\n  ", pack[i]);
+    fprintf(f, "\n};\n");
+  } else {
+    fwrite(pack, 1, total, f);
+  }
+  fclose(f);
+  for (a = 0; a < count; a++)
+    fprintf(stderr, "%08X %6u %-16s %ux%u x%u format %u\n", assets[a].hash,
+            assets[a].size, assets[a].name, assets[a].w, assets[a].h,
+            assets[a].frames, assets[a].format);
+  fprintf(stderr, "%d assets, %u bytes\n", count, total);
+  return 0;
+}
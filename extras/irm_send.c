@@ -0,0 +1,253 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  It's a
+// command-line tool that streams frames to an IRM_StreamDecoder (see
+// irm_stream.h) over a serial port.  Raw frames are read from stdin as
+// R,G,B bytes per pixel, each one sent as whichever of RAW, RLE or DELTA
+// is smallest.  Linux/macOS only.
+//
+// Usage: irm_send -n leds [-b baud] [-r fps] [-k keyint] [-x] [device]
+//   -n  pixels per frame (required)
+//   -b  baud rate when device is a tty (default 115200)
+//   -r  frames per second, 0 = as fast as the link goes (default 0)
+//   -k  force a key frame every keyint frames (default 30)
+//   -x  frames are in display order (row by row), not LED chain order
+//   device defaults to stdout, e.g. to pipe through ssh or socat.
+//
+// Example: ffmpeg -i clip.mp4 -vf scale=16:16 -f rawvideo -pix_fmt rgb24 - |
+//          irm_send -n 256 -b 1000000 -r 30 /dev/ttyUSB0
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FRAME_RAW 0
+#define FRAME_RLE 1
+#define FRAME_DELTA 2
+#define FRAME_XY 0x80
+
+#define OP_LITERAL 0x00
+#define OP_RUN 0x40
+#define OP_SKIP 0x80
+#define OP_MAX 64
+
+#define MAX_PAYLOAD 65535
+
+static int npix;
+
+static int same(const uint8_t *a, const uint8_t *b) {
+  return !memcmp(a, b, 3);
+}
+
+// RLE ops for pixels [i, end), returns bytes written
+static int rle(const uint8_t *pix, int i, int end, uint8_t *out) {
+  int len = 0;
+  while (i < end) {
+    int run = 1;
+    while ((i + run < end) && (run < OP_MAX) &&
+           same(&pix[i * 3], &pix[(i + run) * 3]))
+      run++;
+    if (run > 1) {
+      out[len++] = OP_RUN | (run - 1);
+      memcpy(&out[len], &pix[i * 3], 3);
+      len += 3;
+      i += run;
+      continue;
+    }
+    // Literal up to the next run of two or more
+    int j = i + 1;
+    while ((j < end) && (j - i < OP_MAX) &&
+           !((j + 1 < end) && same(&pix[j * 3], &pix[(j + 1) * 3])))
+      j++;
+    out[len++] = OP_LITERAL | (j - i - 1);
+    memcpy(&out[len], &pix[i * 3], (j - i) * 3);
+    len += (j - i) * 3;
+    i = j;
+  }
+  return len;
+}
+
+// Changed spans RLE'd, unchanged spans skipped; trailing skip omitted
+static int delta(const uint8_t *pix, const uint8_t *prev, uint8_t *out) {
+  int len = 0, i = 0;
+  while (i < npix) {
+    int j = i;
+    while ((j < npix) && same(&pix[j * 3], &prev[j * 3]))
+      j++;
+    if (j == npix)
+      break;
+    while (j - i > 0) {
+      int n = (j - i > OP_MAX) ? OP_MAX : j - i;
+      out[len++] = OP_SKIP | (n - 1);
+      i += n;
+    }
+    while ((j < npix) && !same(&pix[j * 3], &prev[j * 3]))
+      j++;
+    len += rle(pix, i, j, &out[len]);
+    i = j;
+  }
+  return len;
+}
+
+static uint16_t crc16(uint16_t crc, const uint8_t *p, int len) {
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static void writeAll(int fd, const uint8_t *p, int len) {
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) {
+      perror("write");
+      exit(1);
+    }
+    p += n;
+    len -= n;
+  }
+}
+
+static speed_t baudFlag(long baud) {
+  static const struct {
+    long baud;
+    speed_t flag;
+  } rates[] = {
+      {9600, B9600},     {19200, B19200},     {38400, B38400},
+      {57600, B57600},   {115200, B115200},   {230400, B230400},
+#ifdef B460800
+      {460800, B460800}, {500000, B500000},   {921600, B921600},
+      {1000000, B1000000}, {2000000, B2000000},
+#endif
+  };
+  for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    if (rates[i].baud == baud)
+      return rates[i].flag;
+  fprintf(stderr, "Unsupported baud rate %ld\n", baud);
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  long baud = 115200;
+  int fps = 0, keyint = 30, xy = 0, c;
+
+  while ((c = getopt(argc, argv, "n:b:r:k:x")) != -1) {
+    switch (c) {
+    case 'n':
+      npix = atoi(optarg);
+      break;
+    case 'b':
+      baud = atol(optarg);
+      break;
+    case 'r':
+      fps = atoi(optarg);
+      break;
+    case 'k':
+      keyint = atoi(optarg);
+      break;
+    case 'x':
+      xy = FRAME_XY;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s -n leds [-b baud] [-r fps] [-k keyint] "
+                      "[-x] [device]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if ((npix <= 0) || (npix * 3 > MAX_PAYLOAD)) {
+    fprintf(stderr, "-n must be 1..%d\n", MAX_PAYLOAD / 3);
+    return 1;
+  }
+
+  int fd = STDOUT_FILENO;
+  if (optind < argc) {
+    if ((fd = open(argv[optind], O_WRONLY | O_NOCTTY)) < 0) {
+      perror(argv[optind]);
+      return 1;
+    }
+    struct termios tio;
+    if (!tcgetattr(fd, &tio)) {
+      cfmakeraw(&tio);
+      cfsetispeed(&tio, baudFlag(baud));
+      cfsetospeed(&tio, baudFlag(baud));
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+  }
+
+  uint8_t *pix = malloc(npix * 3), *prev = malloc(npix * 3);
+  // Worst case RLE: one control byte per pixel plus the pixel
+  uint8_t *frame = malloc(6 + npix * 4 + 2), *best = malloc(npix * 4);
+  if (!pix || !prev || !frame || !best) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  long sent = 0, bytes = 0;
+  uint8_t seq = 0;
+
+  while (fread(pix, 3, npix, stdin) == (size_t)npix) {
+    int type = FRAME_RAW, len = npix * 3;
+    uint8_t *payload = pix;
+
+    int n = rle(pix, 0, npix, best);
+    if (n < len) {
+      type = FRAME_RLE;
+      len = n;
+      payload = best;
+    }
+    if (sent && (!keyint || (sent % keyint))) {
+      n = delta(pix, prev, &frame[6]);
+      if ((n < len) && (n <= MAX_PAYLOAD)) {
+        type = FRAME_DELTA;
+        len = n;
+        payload = &frame[6];
+      }
+    }
+    if (len > MAX_PAYLOAD) { // RLE can't expand past RAW, so only DELTA
+      type = FRAME_RAW;
+      len = npix * 3;
+      payload = pix;
+    }
+
+    frame[0] = 'I';
+    frame[1] = 'R';
+    frame[2] = type | xy;
+    frame[3] = seq++;
+    frame[4] = len & 0xFF;
+    frame[5] = len >> 8;
+    if (payload != &frame[6])
+      memcpy(&frame[6], payload, len);
+    uint16_t crc = crc16(0xFFFF, &frame[2], 4 + len);
+    frame[6 + len] = crc & 0xFF;
+    frame[7 + len] = crc >> 8;
+
+    if (fps) {
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      next.tv_nsec += 1000000000L / fps;
+      if (next.tv_nsec >= 1000000000L) {
+        next.tv_sec++;
+        next.tv_nsec -= 1000000000L;
+      }
+    }
+    writeAll(fd, frame, 8 + len);
+    memcpy(prev, pix, npix * 3);
+    sent++;
+    bytes += 8 + len;
+  }
+
+  if (fd != STDOUT_FILENO) {
+    tcdrain(fd);
+    close(fd);
+  }
+  fprintf(stderr, "%ld frames, %ld bytes (%.1f%% of raw)\n", sent, bytes,
+          sent ? 100.0 * bytes / (sent * (npix * 3.0 + 8)) : 0.0);
+  return 0;
+}
@@ -0,0 +1,113 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  The parts of
+// Adafruit_NeoPixel that IRM_Mini builds on, for host tests.  show() hands
+// the LED buffer to hostShow, if set, instead of driving a pin.
+
+#ifndef __HOST_ADAFRUIT_NEOPIXEL__
+#define __HOST_ADAFRUIT_NEOPIXEL__
+
+#include <Arduino.h>
+
+// Same packing as the real library: W, R, G, B byte offsets
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_RGBW ((3 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRBW ((2 << 6) | (1 << 4) | (0 << 2) | (3))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+typedef uint16_t neoPixelType;
+
+extern void (*hostShow)(const uint8_t *pixels, uint16_t numBytes);
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t p = 6,
+                    neoPixelType t = NEO_GRB + NEO_KHZ800)
+      : begun(false), numLEDs(0), numBytes(0), pin(p), brightness(0),
+        pixels(NULL) {
+    updateType(t);
+    updateLength(n);
+  }
+  Adafruit_NeoPixel(void)
+      : begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0),
+        pixels(NULL), rOffset(1), gOffset(0), bOffset(2), wOffset(1) {}
+  ~Adafruit_NeoPixel() { free(pixels); }
+
+  void begin(void) { begun = true; }
+  void show(void) {
+    if (hostShow && pixels)
+      hostShow(pixels, numBytes);
+  }
+  void setPin(int16_t p) { pin = p; }
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b,
+                     uint8_t w = 0) {
+    if (n >= numLEDs)
+      return;
+    if (brightness) {
+      r = (r * brightness) >> 8;
+      g = (g * brightness) >> 8;
+      b = (b * brightness) >> 8;
+      w = (w * brightness) >> 8;
+    }
+    uint8_t *p = &pixels[n * ((wOffset == rOffset) ? 3 : 4)];
+    if (wOffset != rOffset)
+      p[wOffset] = w;
+    p[rOffset] = r;
+    p[gOffset] = g;
+    p[bOffset] = b;
+  }
+  void setPixelColor(uint16_t n, uint32_t c) {
+    setPixelColor(n, c >> 16, c >> 8, c, c >> 24);
+  }
+  uint32_t getPixelColor(uint16_t n) const {
+    if (n >= numLEDs)
+      return 0;
+    const uint8_t *p = &pixels[n * ((wOffset == rOffset) ? 3 : 4)];
+    uint32_t w = (wOffset == rOffset) ? 0 : (uint32_t)p[wOffset] << 24;
+    return w | ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) |
+           p[bOffset];
+  }
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0) {
+    uint16_t end = (count && (first + count < numLEDs)) ? first + count
+                                                        : numLEDs;
+    for (uint16_t i = first; i < end; i++)
+      setPixelColor(i, c);
+  }
+  void setBrightness(uint8_t b) { brightness = b + 1; }
+  uint8_t getBrightness(void) const { return brightness - 1; }
+  void clear(void) { memset(pixels, 0, numBytes); }
+  void updateLength(uint16_t n) {
+    free(pixels);
+    numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+    if ((pixels = (uint8_t *)calloc(numBytes, 1)))
+      numLEDs = n;
+    else
+      numLEDs = numBytes = 0;
+  }
+  void updateType(neoPixelType t) {
+    wOffset = (t >> 6) & 3;
+    rOffset = (t >> 4) & 3;
+    gOffset = (t >> 2) & 3;
+    bOffset = t & 3;
+    is800KHz = !(t & NEO_KHZ400);
+  }
+  bool canShow(void) { return true; }
+  uint8_t *getPixels(void) const { return pixels; }
+  int16_t getPin(void) const { return pin; }
+  uint16_t numPixels(void) const { return numLEDs; }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+protected:
+  bool is800KHz;
+  bool begun;
+  uint16_t numLEDs;
+  uint16_t numBytes;
+  int16_t pin;
+  uint8_t brightness;
+  uint8_t *pixels;
+  uint8_t rOffset, gOffset, bOffset, wOffset;
+};
+
+#endif // __HOST_ADAFRUIT_NEOPIXEL__
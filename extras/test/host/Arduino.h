@@ -0,0 +1,87 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  Just enough of
+// the Arduino core for the library to build on a Linux host, for the tests
+// in extras/test.
+
+#ifndef __HOST_ARDUINO__
+#define __HOST_ARDUINO__
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "binary.h" // Generated by the Makefile
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+#define pgm_read_word(a) (*(const uint16_t *)(a))
+#define pgm_read_dword(a) (*(const uint32_t *)(a))
+#define pgm_read_ptr(a) (*(void *const *)(a))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis(void); // Real time, or hostMillis if that's >= 0
+unsigned long micros(void);
+void delay(unsigned long ms);
+void yield(void);
+extern long hostMillis;
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++)
+      write(buf[i]);
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t println(const char *s) { return print(s) + print("\n"); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual size_t readBytes(uint8_t *buf, size_t n) {
+    size_t i = 0;
+    for (int c; (i < n) && ((c = read()) >= 0);)
+      buf[i++] = c;
+    return i;
+  }
+  size_t readBytes(char *buf, size_t n) { return readBytes((uint8_t *)buf, n); }
+};
+
+class String {
+public:
+  String(const char *s = "") : str(s ? s : "") {}
+  const char *c_str() const { return str.c_str(); }
+  unsigned int length() const { return str.size(); }
+
+private:
+  std::string str;
+};
+
+class HardwareSerial : public Stream {
+public:
+  int available() { return 0; }
+  int read() { return -1; }
+  int peek() { return -1; }
+  size_t write(uint8_t c) { return fputc(c, stderr) != EOF; }
+};
+extern HardwareSerial Serial;
+
+#endif // __HOST_ARDUINO__
@@ -0,0 +1,28 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  An SPI bus for
+// host tests that records what is sent.
+
+#ifndef __HOST_SPI__
+#define __HOST_SPI__
+
+#include <Arduino.h>
+#include <vector>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+struct SPISettings {
+  SPISettings(uint32_t hz, uint8_t order, uint8_t mode) {}
+};
+
+class SPIClass {
+public:
+  void beginTransaction(SPISettings s) {}
+  void endTransaction(void) {}
+  void transfer(void *buf, size_t n) {
+    sent.insert(sent.end(), (uint8_t *)buf, (uint8_t *)buf + n);
+  }
+  std::vector<uint8_t> sent; // Everything transferred
+};
+extern SPIClass SPI;
+
+#endif // __HOST_SPI__
@@ -0,0 +1,18 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  The Arduino
+// UDP interface, for host tests.
+
+#ifndef __HOST_UDP__
+#define __HOST_UDP__
+
+#include <Arduino.h>
+
+class UDP : public Stream {
+public:
+  virtual int parsePacket() = 0;
+  virtual int read(unsigned char *buf, size_t len) = 0;
+  virtual int read(char *buf, size_t len) = 0;
+  virtual int read() = 0;
+  virtual void flush() = 0;
+};
+
+#endif // __HOST_UDP__
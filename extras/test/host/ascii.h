@@ -0,0 +1,3 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  irm_mini.h
+// includes "ascii.h", which isn't shipped with the library; the fonts it
+// needs are in irm_mini.cpp, so the host build gets an empty one.
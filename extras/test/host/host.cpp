@@ -0,0 +1,26 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  Definitions
+// behind the host stand-ins for the Arduino core and libraries.
+
+#include <Adafruit_NeoPixel.h>
+#include <SPI.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+SPIClass SPI;
+void (*hostShow)(const uint8_t *pixels, uint16_t numBytes) = NULL;
+long hostMillis = -1;
+
+unsigned long micros(void) {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1000000UL + t.tv_usec;
+}
+
+unsigned long millis(void) {
+  return (hostMillis >= 0) ? hostMillis : micros() / 1000;
+}
+
+void delay(unsigned long ms) { usleep(ms * 1000); }
+
+void yield(void) {}
@@ -0,0 +1,183 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  Host test for
+// the matrix/tile layout: for every NEO_MATRIX/NEO_TILE combination, tiled
+// and untiled, in all four rotations, each display pixel must land on the
+// LED that the original NeoMatrix drawPixel() picked.  mapXY() and
+// drawPixel() are checked against that reference, then drawRow(),
+// drawPixels() and fillRect() against drawPixel().  Run with `make`.
+
+#include <irm_mini.h>
+#include <vector>
+
+static int cases, failures;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    cases++;                                                                   \
+    if (!(cond) && (failures++ < 10)) {                                        \
+      printf("FAIL %s: ", #cond);                                              \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+    }                                                                          \
+  } while (0)
+
+// The original Adafruit_NeoMatrix mapping: undo the rotation, then walk
+// the tile and matrix layout
+static uint16_t refXY(int16_t x, int16_t y, uint8_t rotation, uint8_t type,
+                      uint8_t mW, uint8_t mH, uint8_t tX, uint8_t tY) {
+  int16_t W = mW * (tX ? tX : 1), H = mH * (tY ? tY : 1), t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = W - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = W - 1 - x;
+    y = H - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = H - 1 - t;
+    break;
+  }
+
+  uint8_t corner = type & NEO_MATRIX_CORNER;
+  uint16_t minor, major, majorScale, tileOffset = 0, pixelOffset;
+  if (tX) {
+    uint16_t tile;
+    minor = x / mW;
+    major = y / mH;
+    x -= minor * mW;
+    y -= major * mH;
+    if (type & NEO_TILE_RIGHT)
+      minor = tX - 1 - minor;
+    if (type & NEO_TILE_BOTTOM)
+      major = tY - 1 - major;
+    if ((type & NEO_TILE_AXIS) == NEO_TILE_ROWS) {
+      majorScale = tX;
+    } else {
+      std::swap(major, minor);
+      majorScale = tY;
+    }
+    if ((type & NEO_TILE_SEQUENCE) == NEO_TILE_PROGRESSIVE) {
+      tile = major * majorScale + minor;
+    } else if (major & 1) {
+      // irm_mini.cpp defines NEO_TILE_ZIGZAG_NOFLIP: the matrix corner
+      // stays put on reversed tile rows
+      tile = (major + 1) * majorScale - 1 - minor;
+    } else {
+      tile = major * majorScale + minor;
+    }
+    tileOffset = tile * mW * mH;
+  }
+
+  minor = x;
+  major = y;
+  if (corner & NEO_MATRIX_RIGHT)
+    minor = mW - 1 - minor;
+  if (corner & NEO_MATRIX_BOTTOM)
+    major = mH - 1 - major;
+  if ((type & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS) {
+    majorScale = mW;
+  } else {
+    std::swap(major, minor);
+    majorScale = mH;
+  }
+  if (((type & NEO_MATRIX_SEQUENCE) == NEO_MATRIX_PROGRESSIVE) || !(major & 1))
+    pixelOffset = major * majorScale + minor;
+  else
+    pixelOffset = (major + 1) * majorScale - 1 - minor;
+  return tileOffset + pixelOffset;
+}
+
+static void checkLayout(uint8_t type, uint8_t mW, uint8_t mH, uint8_t tX,
+                        uint8_t tY) {
+  // int sizes pick the single-matrix constructor, uint8_t the tiled one
+  IRM_Mini *m = tX ? new IRM_Mini(mW, mH, tX, tY, 6, type, NEO_GRB)
+                   : new IRM_Mini((int)mW, (int)mH, 6, type, NEO_GRB);
+  m->begin();
+  uint16_t n = m->numPixels();
+  uint16_t bytes = n * 3;
+  std::vector<uint8_t> a(bytes);
+  std::vector<int16_t> xs(n), ys(n);
+  std::vector<uint16_t> colors(n);
+
+  for (uint8_t r = 0; r < 4; r++) {
+    m->setRotation(r);
+    int16_t W = m->width(), H = m->height();
+    uint8_t *leds = m->getPixels();
+
+    // Every pixel in its own raw color: drawPixel() and mapXY() must
+    // agree with the reference on every LED
+    for (int16_t y = 0, i = 0; y < H; y++) {
+      for (int16_t x = 0; x < W; x++, i++) {
+        uint16_t led = refXY(x, y, r, type, mW, mH, tX, tY);
+        CHECK(m->mapXY(x, y) == led, "type %02X tiles %d rot %d (%d,%d)",
+              type, tX, r, x, y);
+        m->setPassThruColor(i + 1);
+        m->drawPixel(x, y, 0);
+        xs[i] = x;
+        ys[i] = y;
+        colors[i] = (uint16_t)(i * 0x9E37 + 0x1234); // Any mix of colors
+      }
+    }
+    m->setPassThruColor();
+    for (int16_t y = 0, i = 0; y < H; y++)
+      for (int16_t x = 0; x < W; x++, i++)
+        CHECK(m->getPixelColor(refXY(x, y, r, type, mW, mH, tX, tY)) ==
+                  (uint32_t)i + 1,
+              "type %02X tiles %d rot %d (%d,%d) drawPixel", type, tX, r, x,
+              y);
+
+    // The same image through each batched path
+    m->clear();
+    for (uint16_t i = 0; i < n; i++)
+      m->drawPixel(xs[i], ys[i], colors[i]);
+    memcpy(&a[0], leds, bytes);
+
+    m->clear();
+    for (int16_t y = 0; y < H; y++)
+      m->drawRow(0, y, &colors[y * W], W);
+    CHECK(!memcmp(&a[0], leds, bytes), "type %02X tiles %d rot %d drawRow",
+          type, tX, r);
+
+    m->clear();
+    m->drawPixels(&xs[0], &ys[0], &colors[0], n);
+    CHECK(!memcmp(&a[0], leds, bytes), "type %02X tiles %d rot %d drawPixels",
+          type, tX, r);
+
+    // A rectangle inside the edges, and one hanging off them
+    for (uint8_t k = 0; k < 2; k++) {
+      int16_t x0 = k ? -1 : W / 4, y0 = k ? H / 3 : 1;
+      int16_t w = k ? W : W / 2, h = k ? H : H - 2;
+      m->clear();
+      for (int16_t y = max(y0, (int16_t)0); y < min(y0 + h, (int)H); y++)
+        for (int16_t x = max(x0, (int16_t)0); x < min(x0 + w, (int)W); x++)
+          m->drawPixel(x, y, 0x07E0);
+      memcpy(&a[0], leds, bytes);
+      m->clear();
+      m->fillRect(x0, y0, w, h, 0x07E0);
+      CHECK(!memcmp(&a[0], leds, bytes), "type %02X tiles %d rot %d fillRect",
+            type, tX, r);
+    }
+  }
+  delete m;
+}
+
+int main(void) {
+  // Matrix width and height, tiles across and down
+  static const uint8_t sizes[][4] = {
+      {8, 8, 6, 2}, {4, 3, 3, 2}, {5, 2, 2, 3}, {3, 3, 1, 4}};
+
+  for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const uint8_t *d = sizes[s];
+    for (uint16_t type = 0; type < 256; type++) {
+      checkLayout(type, d[0], d[1], d[2], d[3]);
+      if (!(type & 0xF0)) // Tile bits only matter when tiled
+        checkLayout(type, d[0] * d[2], d[1] * d[3], 0, 0);
+    }
+  }
+  printf("test_layout: %d checks, %d failures\n", cases, failures);
+  return failures != 0;
+}
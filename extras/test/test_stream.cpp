@@ -0,0 +1,212 @@
+// THIS IS NOT ARDUINO CODE -- DON'T INCLUDE IN YOUR SKETCH.  Loopback test
+// for the stream protocol: frames are piped through extras/irm_send.c onto
+// a pseudo-terminal, read back from the other end into an
+// IRM_StreamDecoder, and every frame show()n must match the one that went
+// in.  Runs in chain and display order, with RGB (copied straight in) and
+// GRB (converted) wire formats.  Also checks that frames with a bad CRC or
+// an unknown type aren't shown.  Run with `make`.
+
+#include <irm_stream.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define W 16
+#define H 8
+#define FRAMES 60
+
+static int cases, failures;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    cases++;                                                                   \
+    if (!(cond) && (failures++ < 10)) {                                        \
+      printf("FAIL %s: ", #cond);                                              \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+    }                                                                          \
+  } while (0)
+
+static uint8_t frames[FRAMES][W * H * 3]; // R,G,B in display order
+static IRM_Mini *matrix;
+static bool displayOrder;
+static int shown;
+
+// A mix that gives irm_send every frame type: still and moving content
+// for deltas, flat areas for RLE, noise for RAW, and repeats (empty deltas)
+static void makeFrames(void) {
+  uint32_t seed = 1;
+  for (int f = 0; f < FRAMES; f++) {
+    uint8_t *p = frames[f];
+    for (int y = 0; y < H; y++) {
+      for (int x = 0; x < W; x++, p += 3) {
+        bool box = (x >= f % W) && (x < f % W + 4) && (y >= 2) && (y < 6);
+        p[0] = box ? 255 : x * 16;
+        p[1] = box ? 128 : y * 32;
+        p[2] = (f / 10) * 40;
+        if ((f % 17) == 16) { // Noise
+          seed = seed * 1103515245 + 12345;
+          p[0] = seed >> 24;
+          p[1] = seed >> 16;
+          p[2] = seed >> 8;
+        }
+      }
+    }
+    if ((f % 13) == 12)
+      memcpy(frames[f], frames[f - 1], sizeof(frames[f]));
+  }
+}
+
+// Called by show(): the LED buffer must hold the next frame
+static void checkShow(const uint8_t *pixels, uint16_t numBytes) {
+  CHECK(shown < FRAMES, "frame %d shown", shown);
+  if (shown >= FRAMES)
+    return;
+  const uint8_t *p = frames[shown];
+  int bad = 0;
+  for (int y = 0; y < H; y++) {
+    for (int x = 0; x < W; x++, p += 3) {
+      uint16_t led = displayOrder ? matrix->mapXY(x, y) : y * W + x;
+      bad += matrix->getPixelColor(led) !=
+             Adafruit_NeoPixel::Color(p[0], p[1], p[2]);
+    }
+  }
+  CHECK(!bad, "frame %d has %d wrong pixels", shown, bad);
+  shown++;
+}
+
+// Send all frames through irm_send and a pty into a decoder
+static void loopback(neoPixelType wire, bool xy) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((master < 0) || grantpt(master) || unlockpt(master)) {
+    perror("pty");
+    exit(1);
+  }
+  const char *tty = ptsname(master);
+  // Held open so the pty stays up until everything is read
+  int slave = open(tty, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  tcgetattr(slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+
+  int in[2];
+  if (pipe(in)) {
+    perror("pipe");
+    exit(1);
+  }
+  pid_t pid = fork();
+  if (!pid) {
+    dup2(in[0], STDIN_FILENO);
+    close(in[0]);
+    close(in[1]);
+    char n[8];
+    snprintf(n, sizeof(n), "%d", W * H);
+    const char *args[] = {"irm_send", "-n", n, "-k", "7", tty, NULL, NULL};
+    if (xy) {
+      args[5] = "-x";
+      args[6] = tty;
+    }
+    execv("./irm_send", (char *const *)args);
+    perror("irm_send");
+    _exit(1);
+  }
+  close(in[0]);
+
+  // Frames in chain order are the same bytes: the matrix is progressive
+  uint8_t matrixType = xy ? NEO_MATRIX_TOP + NEO_MATRIX_RIGHT +
+                                NEO_MATRIX_COLUMNS + NEO_MATRIX_ZIGZAG
+                          : NEO_MATRIX_TOP + NEO_MATRIX_LEFT +
+                                NEO_MATRIX_ROWS + NEO_MATRIX_PROGRESSIVE;
+  IRM_Mini m(W, H, 6, matrixType, wire);
+  m.begin();
+  IRM_StreamDecoder decoder(m);
+  matrix = &m;
+  displayOrder = xy;
+  shown = 0;
+  hostShow = checkShow;
+
+  // Fits in the pipe, so irm_send can't stall on it
+  if (write(in[1], frames, sizeof(frames)) != (ssize_t)sizeof(frames))
+    perror("write");
+  close(in[1]);
+
+  bool done = false;
+  for (;;) {
+    struct pollfd pfd = {master, POLLIN, 0};
+    if (poll(&pfd, 1, done ? 200 : 50) > 0) {
+      uint8_t buf[256];
+      ssize_t n = read(master, buf, sizeof(buf));
+      for (ssize_t i = 0; i < n; i++)
+        decoder.feed(buf[i]);
+    } else if (done) {
+      break; // irm_send is gone and the pty is drained
+    } else {
+      done = waitpid(pid, NULL, WNOHANG) == pid;
+    }
+  }
+  hostShow = NULL;
+  close(slave);
+  close(master);
+
+  const IRM_StreamStats &s = decoder.stats();
+  CHECK((shown == FRAMES) && (s.frames == FRAMES),
+        "%s %s: %d of %d frames shown", xy ? "xy" : "chain",
+        (wire == NEO_RGB) ? "RGB" : "GRB", shown, FRAMES);
+  CHECK(!s.crcErrors && !s.dropped && !s.resyncs,
+        "%u CRC errors, %u dropped, %u resyncs", s.crcErrors, s.dropped,
+        s.resyncs);
+}
+
+static uint16_t crc16(const uint8_t *p, int len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// A one-run frame for a 2x2 matrix; bad = 1 breaks its CRC
+static bool feedFrame(IRM_StreamDecoder &d, uint8_t type, uint8_t seq,
+                      int bad) {
+  uint8_t f[] = {'I', 'R', type, seq, 4, 0, IRM_OP_RUN | 3, 1, 2, 3, 0, 0};
+  if ((type & 3) == IRM_FRAME_RAW)
+    f[6] = 0;
+  uint16_t crc = crc16(&f[2], 8) ^ bad;
+  f[10] = crc & 0xFF;
+  f[11] = crc >> 8;
+  bool done = false;
+  for (size_t i = 0; i < sizeof(f); i++)
+    done |= d.feed(f[i]);
+  return done;
+}
+
+static void rejects(void) {
+  IRM_Mini m(2, 2);
+  m.begin();
+  IRM_StreamDecoder d(m);
+  CHECK(feedFrame(d, IRM_FRAME_RLE, 0, 0), "key frame shown");
+  CHECK(!feedFrame(d, IRM_FRAME_DELTA, 1, 1), "bad CRC not shown");
+  CHECK(!feedFrame(d, IRM_FRAME_DELTA, 2, 0), "delta after bad CRC dropped");
+  CHECK(!feedFrame(d, 3, 3, 0), "unknown type dropped");
+  CHECK(feedFrame(d, IRM_FRAME_RLE, 4, 0), "next key frame shown");
+  const IRM_StreamStats &s = d.stats();
+  CHECK((s.frames == 2) && (s.crcErrors == 1) && (s.dropped == 2),
+        "%u frames, %u CRC errors, %u dropped", s.frames, s.crcErrors,
+        s.dropped);
+}
+
+int main(void) {
+  makeFrames();
+  loopback(NEO_RGB, false);
+  loopback(NEO_GRB, false);
+  loopback(NEO_RGB, true);
+  loopback(NEO_GRB, true);
+  rejects();
+  printf("test_stream: %d checks, %d failures\n", cases, failures);
+  return failures != 0;
+}
@@ -0,0 +1,54 @@
+/*!
+ * @file irm_apa102.cpp
+ *
+ * APA102 / SK9822 output for IRM_Mini, see irm_apa102.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_apa102.h"
+
+IRM_APA102Output::IRM_APA102Output(SPIClass &s, uint32_t hz, uint8_t level)
+    : spi(s), clockHz(hz) {
+  setLevel(level);
+  partialOK = false; // The LED after a short frame would latch the end bits
+}
+
+// Start frame: 32 zero bits
+void IRM_APA102Output::beginFrame(uint16_t count) {
+  frameLEDs = count;
+  spi.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE0));
+  memset(chunk, 0, 4);
+  spi.transfer(chunk, 4);
+}
+
+// Each LED: 111 + 5-bit level, then blue, green, red
+void IRM_APA102Output::write(const uint8_t *data, uint16_t count) {
+  while (count) {
+    uint16_t n = (count < IRM_APA102_CHUNK) ? count : IRM_APA102_CHUNK;
+    uint8_t *p = chunk;
+    for (uint16_t i = 0; i < n; i++, data += fmt.bpp) {
+      *p++ = header;
+      *p++ = data[fmt.b];
+      *p++ = data[fmt.g];
+      *p++ = data[fmt.r];
+    }
+    spi.transfer(chunk, n * 4); // In place; chunk is refilled next time
+    count -= n;
+  }
+}
+
+// Data is delayed half a clock per LED, so clock out one more bit per two
+// LEDs. Ones, as Adafruit_DotStar does, so the SK9822 sees no new start.
+void IRM_APA102Output::endFrame(void) {
+  uint16_t n = (frameLEDs + 15) / 16;
+  while (n) {
+    uint16_t k = (n < sizeof(chunk)) ? n : sizeof(chunk);
+    memset(chunk, 0xFF, k);
+    spi.transfer(chunk, k);
+    n -= k;
+  }
+  spi.endTransaction();
+}
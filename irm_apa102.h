@@ -0,0 +1,56 @@
+/*!
+ * @file irm_apa102.h
+ *
+ * APA102 / SK9822 (DotStar) output for IRM_Mini over hardware SPI.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_APA102__
+#define __IRM_APA102__
+
+#include "irm_mini.h"
+#include <SPI.h>
+
+#define IRM_APA102_CHUNK 32 ///< LEDs converted per SPI block transfer
+
+/**
+ * @brief APA102/SK9822 chain on the hardware SPI bus, clocked far faster
+ *        than WS2812 timing allows. LED data is converted to the chips'
+ *        4-byte frames a chunk at a time and sent with SPIClass block
+ *        transfers, so there's no frame-sized buffer. Call SPI.begin()
+ *        (with pins, on ESP32) before IRM_Mini::setOutput().
+ */
+class IRM_APA102Output : public IRM_Output {
+public:
+  /**
+   * @brief  Describe the bus.
+   * @param  spi      SPI port.
+   * @param  clockHz  SPI clock; APA102 runs to ~20 MHz, SK9822 ~15 MHz.
+   * @param  level    5-bit global current level, 1-31, for every LED.
+   */
+  IRM_APA102Output(SPIClass &spi = SPI, uint32_t clockHz = 8000000,
+                   uint8_t level = 31);
+
+  /**
+   * @brief  Change the global current level, e.g. to dim without losing
+   *         PWM resolution.
+   * @param  level  1-31.
+   */
+  void setLevel(uint8_t level) { header = 0xE0 | (level & 0x1F); }
+
+  void beginFrame(uint16_t count);
+  void write(const uint8_t *data, uint16_t count);
+  void endFrame(void);
+
+private:
+  SPIClass &spi;
+  uint32_t clockHz;
+  uint8_t header;
+  uint16_t frameLEDs = 0;
+  uint8_t chunk[IRM_APA102_CHUNK * 4];
+};
+
+#endif // __IRM_APA102__
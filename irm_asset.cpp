@@ -0,0 +1,173 @@
+/*!
+ * @file irm_asset.cpp
+ *
+ * Asset packs for IRM_Mini, see irm_asset.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_asset.h"
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+#define PACK_HEADER 12 // Bytes before the index
+#define PACK_ENTRY 20  // Bytes per index entry
+
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static uint32_t get32(const uint8_t *p) {
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+uint32_t IRM_Asset::frameSize(void) const {
+  uint32_t pixels = (uint32_t)width * height;
+  uint32_t mono = (uint32_t)((width + 7) >> 3) * height;
+  switch (format) {
+  case IRM_ASSET_RGB565: // Saturates rather than wrap, for at()'s check
+    return (pixels > 0x7FFFFFFFUL) ? 0xFFFFFFFFUL : pixels * 2;
+  case IRM_ASSET_MONO:
+    return mono;
+  case IRM_ASSET_FONT:
+    return 1 + mono;
+  default:
+    return 0;
+  }
+}
+
+uint32_t IRM_AssetPack::hash(const char *name) {
+  uint32_t h = 2166136261UL;
+  while (*name) {
+    h ^= (uint8_t)*name++;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+// Copy pack bytes from whichever source the pack has
+bool IRM_AssetPack::fetch(uint32_t offset, uint8_t *buf, size_t len) const {
+  if ((offset > length) || (len > length - offset))
+    return false;
+  if (reader)
+    return reader(ctx, offset, buf, len) == len;
+  if (progmem) {
+    for (size_t i = 0; i < len; i++)
+      buf[i] = pgm_read_byte(&mem[offset + i]);
+  } else {
+    memcpy(buf, &mem[offset], len);
+  }
+  return true;
+}
+
+bool IRM_AssetPack::readHeader(void) {
+  uint8_t h[PACK_HEADER];
+  uint32_t limit = length;
+  entries = 0;
+  length = PACK_HEADER;
+  if (!fetch(0, h, PACK_HEADER) || memcmp(h, "IRMA", 4) ||
+      (h[4] != IRM_ASSET_VERSION))
+    return false;
+  length = get32(&h[8]);
+  if ((length > limit) ||
+      (length < PACK_HEADER + (uint32_t)get16(&h[6]) * PACK_ENTRY))
+    return false;
+  entries = get16(&h[6]);
+  return true;
+}
+
+bool IRM_AssetPack::begin(const uint8_t *data, size_t len, bool pgm) {
+  mem = data;
+  progmem = pgm;
+  reader = NULL;
+  length = len;
+  return readHeader();
+}
+
+bool IRM_AssetPack::begin(IRM_AssetReader r, void *c) {
+  mem = NULL;
+  reader = r;
+  ctx = c;
+  length = 0xFFFFFFFFUL; // Until the header gives it
+  return readHeader();
+}
+
+#if defined(ESP32)
+// Only the pack's own length is mapped, not the whole partition: mapped
+// flash comes out of a limited address window
+bool IRM_AssetPack::beginPartition(const char *label) {
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  uint8_t h[PACK_HEADER];
+  if (!part || (esp_partition_read(part, 0, h, PACK_HEADER) != ESP_OK) ||
+      memcmp(h, "IRMA", 4))
+    return false;
+  uint32_t len = get32(&h[8]);
+  const void *ptr;
+  uint32_t handle; // spi_flash_mmap_handle_t / esp_partition_mmap_handle_t
+  if ((len > part->size) ||
+      (esp_partition_mmap(part, 0, len, ESP_PARTITION_MMAP_DATA, &ptr,
+                          &handle) != ESP_OK))
+    return false;
+  return begin((const uint8_t *)ptr, len, false);
+}
+#endif
+
+IRM_Asset IRM_AssetPack::at(uint16_t i) const {
+  IRM_Asset a = {};
+  uint8_t e[PACK_ENTRY];
+  if ((i >= entries) || !fetch(PACK_HEADER + (uint32_t)i * PACK_ENTRY, e,
+                               PACK_ENTRY))
+    return a;
+  a.offset = get32(&e[4]);
+  a.size = get32(&e[8]);
+  if ((a.offset > length) || (a.size > length - a.offset))
+    return a;
+  a.width = get16(&e[12]);
+  a.height = get16(&e[14]);
+  a.frames = get16(&e[16]);
+  a.format = e[18];
+  a.base = e[19];
+  if ((uint64_t)a.frameSize() * a.frames > a.size)
+    return a;
+  a.pack = this;
+  return a;
+}
+
+// Binary search on the hash, reading only the hash of each probed entry
+IRM_Asset IRM_AssetPack::find(const char *name) const {
+  uint32_t h = hash(name);
+  uint16_t lo = 0, hi = entries;
+  while (lo < hi) {
+    uint16_t mid = lo + ((hi - lo) >> 1);
+    uint8_t e[4];
+    if (!fetch(PACK_HEADER + (uint32_t)mid * PACK_ENTRY, e, 4))
+      break;
+    uint32_t v = get32(e);
+    if (v == h)
+      return at(mid);
+    if (v < h)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  IRM_Asset none = {};
+  return none;
+}
+
+const uint8_t *IRM_AssetPack::map(const IRM_Asset &asset) const {
+  if (!mem || progmem || (asset.pack != this))
+    return NULL;
+  return &mem[asset.offset];
+}
+
+size_t IRM_AssetPack::read(const IRM_Asset &asset, uint32_t offset,
+                           uint8_t *buf, size_t len) const {
+  if ((asset.pack != this) || (offset >= asset.size))
+    return 0;
+  if (len > asset.size - offset)
+    len = asset.size - offset;
+  return fetch(asset.offset + offset, buf, len) ? len : 0;
+}
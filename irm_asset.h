@@ -0,0 +1,194 @@
+/*!
+ * @file irm_asset.h
+ *
+ * Asset packs for IRM_Mini: icons, animations, fonts and images in one
+ * binary blob with a sorted index, so new artwork needs no recompile.
+ * extras/irm_pack.c builds packs. A pack can be flashed to a data
+ * partition and used in place through memory-mapped flash (ESP32), kept in
+ * PROGMEM or RAM, or read in chunks through a callback (files, external
+ * flash).
+ *
+ * Pack layout (multi-byte fields little-endian):
+ *
+ *   'I' 'R' 'M' 'A' | version (1) | 0 | count (2) | length (4)
+ *   count index entries, sorted by hash:
+ *     hash (4) | offset (4) | size (4) | width (2) | height (2) |
+ *     frames (2) | format (1) | base (1)
+ *   asset data, each asset starting on a 4-byte boundary
+ *
+ * hash is 32-bit FNV-1a of the asset name; the packer refuses names whose
+ * hashes collide, so lookups compare hashes only and names aren't stored.
+ * offset is from the start of the pack. Formats:
+ *
+ *   IRM_ASSET_RAW     Opaque bytes, for the sketch to interpret.
+ *   IRM_ASSET_RGB565  frames images of width x height '565' pixels.
+ *   IRM_ASSET_MONO    frames 1-bit images, rows padded to whole bytes,
+ *                     most significant bit leftmost.
+ *   IRM_ASSET_FONT    frames glyphs for characters base, base + 1, ...,
+ *                     each a width byte and then a MONO image of the cell.
+ *   IRM_ASSET_QOI     A QOI image (see irm_qoi.h), drawn as it decodes.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_ASSET__
+#define __IRM_ASSET__
+
+#include "irm_mini.h"
+
+#define IRM_ASSET_RAW 0    ///< Opaque bytes
+#define IRM_ASSET_RGB565 1 ///< '565' pixels, frame after frame
+#define IRM_ASSET_MONO 2   ///< 1-bit pixels, drawn in one color
+#define IRM_ASSET_FONT 3   ///< Proportional 1-bit font
+#define IRM_ASSET_QOI 4    ///< QOI image
+
+#define IRM_ASSET_VERSION 1 ///< Pack format version
+
+class IRM_AssetPack;
+
+/**
+ * @brief Handle to one asset in a pack, from IRM_AssetPack::find(). It is
+ *        a few bytes and can be copied freely; it stays good as long as
+ *        the pack does.
+ */
+struct IRM_Asset {
+  const IRM_AssetPack *pack; ///< Pack holding the asset, NULL if not found
+  uint32_t offset;           ///< Start of the data within the pack
+  uint32_t size;             ///< Data length in bytes
+  uint16_t width;            ///< Image or glyph cell width
+  uint16_t height;           ///< Image or glyph cell height
+  uint16_t frames;           ///< Frames, or glyphs in a font
+  uint8_t format;            ///< IRM_ASSET_RAW etc.
+  uint8_t base;              ///< First character of a font
+
+  /**
+   * @brief  Whether the handle refers to an asset.
+   * @return false if find() didn't find it.
+   */
+  bool valid(void) const { return pack != NULL; }
+
+  /**
+   * @brief  Bytes per frame (per glyph for fonts).
+   * @return Frame size, 0 for RAW and QOI assets.
+   */
+  uint32_t frameSize(void) const;
+};
+
+/**
+ * @brief Reads pack bytes for chunked access.
+ * @param ctx     Whatever was given to IRM_AssetPack::begin().
+ * @param offset  Offset from the start of the pack.
+ * @param buf     Destination.
+ * @param len     Bytes wanted.
+ * @return Bytes read.
+ */
+typedef size_t (*IRM_AssetReader)(void *ctx, uint32_t offset, uint8_t *buf,
+                                  size_t len);
+
+/**
+ * @brief An asset pack. Lookups are a binary search of the index, so a
+ *        name costs log2(count) entry reads and nothing is loaded up
+ *        front. Draw assets with IRM_Mini::drawAsset() and
+ *        IRM_Mini::drawAscii().
+ *
+ *        For a pack on a file system, give begin() a reader such as:
+ *
+ *          size_t readPack(void *f, uint32_t off, uint8_t *buf, size_t n) {
+ *            File &file = *(File *)f;
+ *            return file.seek(off) ? file.read(buf, n) : 0;
+ *          }
+ */
+class IRM_AssetPack {
+public:
+  /**
+   * @brief  Use a pack that is directly addressable: in RAM, in PROGMEM,
+   *         or memory-mapped.
+   * @param  data     Start of the pack.
+   * @param  len      Bytes available at data.
+   * @param  progmem  true if data is in PROGMEM.
+   * @return true if the pack header is valid and the pack fits in len.
+   */
+  bool begin(const uint8_t *data, size_t len, bool progmem = false);
+
+  /**
+   * @brief  Use a pack read in chunks.
+   * @param  reader  Reads pack bytes.
+   * @param  ctx     Passed to reader.
+   * @return true if the pack header is valid.
+   */
+  bool begin(IRM_AssetReader reader, void *ctx);
+
+#if defined(ESP32)
+  /**
+   * @brief  Memory-map a pack flashed to a data partition, e.g. with
+   *         "parttool.py write_partition --partition-name assets
+   *         --input pack.bin". Mapped assets are drawn straight from flash
+   *         with no copies.
+   * @param  label  Partition label from the partition table.
+   * @return true if the partition holds a valid pack and was mapped.
+   */
+  bool beginPartition(const char *label);
+#endif
+
+  /**
+   * @brief  Number of assets.
+   * @return Asset count, 0 before a successful begin().
+   */
+  uint16_t count(void) const { return entries; }
+
+  /**
+   * @brief  Look up an asset by name.
+   * @param  name  Name given to the packer.
+   * @return Handle; check valid().
+   */
+  IRM_Asset find(const char *name) const;
+
+  /**
+   * @brief  Asset by index position, e.g. to list a pack.
+   * @param  i  0 to count() - 1, in hash order.
+   * @return Handle; not valid() if i is out of range.
+   */
+  IRM_Asset at(uint16_t i) const;
+
+  /**
+   * @brief  Direct pointer to an asset's data, for packs in RAM or mapped
+   *         flash.
+   * @param  asset  Asset in this pack.
+   * @return Data pointer, or NULL if the pack is in PROGMEM or read in
+   *         chunks (use read()).
+   */
+  const uint8_t *map(const IRM_Asset &asset) const;
+
+  /**
+   * @brief  Copy part of an asset's data, from any kind of pack.
+   * @param  asset   Asset in this pack.
+   * @param  offset  Offset within the asset.
+   * @param  buf     Destination.
+   * @param  len     Bytes wanted.
+   * @return Bytes copied; fewer than len at the end of the asset.
+   */
+  size_t read(const IRM_Asset &asset, uint32_t offset, uint8_t *buf,
+              size_t len) const;
+
+  /**
+   * @brief  The packer's name hash (32-bit FNV-1a).
+   * @param  name  Asset name.
+   * @return Hash.
+   */
+  static uint32_t hash(const char *name);
+
+private:
+  bool fetch(uint32_t offset, uint8_t *buf, size_t len) const;
+  bool readHeader(void);
+
+  const uint8_t *mem = NULL; // Addressable pack, or NULL for a reader
+  bool progmem = false;
+  IRM_AssetReader reader = NULL;
+  void *ctx = NULL;
+  uint32_t length = 0;
+  uint16_t entries = 0;
+};
+
+#endif // __IRM_ASSET__
@@ -0,0 +1,121 @@
+/*!
+ * @file irm_clock.cpp
+ *
+ * Digital clock widget for IRM_Mini, see irm_clock.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_clock.h"
+
+#define CLOCK_CELLS 8 // "HH:MM:SS"
+
+void IRM_ClockWidget::setPosition(int16_t x, int16_t y, uint16_t color,
+                                  uint16_t bg, uint8_t fontSize) {
+  posX = x;
+  posY = y;
+  fg = color;
+  bgColor = bg;
+  font = fontSize;
+
+  // Every digit gets the widest digit's cell, so nothing shifts as the
+  // time changes. Cells include a spacing column on the right.
+  uint8_t rows[FONT7];
+  digitW = 0;
+  for (char c = '0'; c <= '9'; c++)
+    digitW = max(digitW, IRM_Mini::glyph(c, font, rows));
+  digitW++;
+  colonW = IRM_Mini::glyph(':', font, rows) + 1;
+  invalidate();
+}
+
+void IRM_ClockWidget::setOptions(bool secs, bool blinkColon) {
+  showSeconds = secs;
+  blink = blinkColon;
+}
+
+void IRM_ClockWidget::setTime(uint8_t hour, uint8_t minute, uint8_t second) {
+  hours = hour;
+  minutes = minute;
+  seconds = second;
+  ms = 0;
+  timeSet = true;
+}
+
+int16_t IRM_ClockWidget::width(void) const {
+  return showSeconds ? 6 * digitW + 2 * colonW : 4 * digitW + colonW;
+}
+
+void IRM_ClockWidget::update(uint32_t dt) {
+  if (!timeSet)
+    return;
+  uint32_t t = ms + dt;
+  ms = t % 1000;
+  uint32_t s = ((uint32_t)hours * 60 + minutes) * 60 + seconds + t / 1000;
+  s %= 86400UL;
+  hours = s / 3600;
+  minutes = (s / 60) % 60;
+  seconds = s % 60;
+}
+
+// Left shift that places a glyph row, centered, in a cell's bit mask
+static uint8_t cellShift(uint8_t cell, uint8_t w) {
+  uint8_t off = (cell - 1 > w) ? (cell - 1 - w) / 2 : 0;
+  return (cell > off + w) ? cell - off - w : 0;
+}
+
+// Write the pixels that differ between glyph 'from' and glyph 'to' (all
+// of them if 'from' is 0, i.e. unknown).
+void IRM_ClockWidget::drawCell(IRM_Mini &matrix, int16_t x, uint8_t cell,
+                               char from, char to) {
+  uint8_t oldRows[FONT7], newRows[FONT7];
+  uint8_t newShift = cellShift(cell, IRM_Mini::glyph(to, font, newRows));
+  uint8_t oldShift = 0;
+  if (from)
+    oldShift = cellShift(cell, IRM_Mini::glyph(from, font, oldRows));
+
+  uint16_t all = (1 << cell) - 1;
+  for (uint8_t j = 0; j < font; j++) {
+    // Bit (cell - 1 - col) is column col of the cell
+    uint16_t now = ((uint16_t)newRows[j] << newShift) & all;
+    uint16_t diff = from ? (now ^ ((uint16_t)oldRows[j] << oldShift)) & all
+                         : all;
+    for (uint8_t col = 0; diff; col++) {
+      uint16_t bit = 1 << (cell - 1 - col);
+      if (diff & bit) {
+        matrix.drawPixel(x + col, posY + j, (now & bit) ? fg : bgColor);
+        diff &= ~bit;
+      }
+    }
+  }
+}
+
+void IRM_ClockWidget::render(IRM_Mini &matrix) {
+  if (!timeSet)
+    return;
+
+  char text[CLOCK_CELLS + 1];
+  char sep = (blink && (ms >= 500)) ? ' ' : ':';
+  // Fields are already in range; % 100 lets the compiler see they fit
+  unsigned h = hours % 100u, m = minutes % 100u, s = seconds % 100u;
+  if (showSeconds)
+    snprintf(text, sizeof(text), "%02u%c%02u%c%02u", h, sep, m, sep, s);
+  else
+    snprintf(text, sizeof(text), "%02u%c%02u", h, sep, m);
+
+  int16_t x = posX;
+  bool ended = false;
+  for (uint8_t i = 0; i < CLOCK_CELLS; i++) {
+    char to = ended ? 0 : text[i];
+    ended = !to;
+    uint8_t cell = ((i == 2) || (i == 5)) ? colonW : digitW;
+    if (shown[i] != to) {
+      // Cells dropped by turning seconds off are blanked
+      drawCell(matrix, x, cell, shown[i], to ? to : ' ');
+      shown[i] = to;
+    }
+    x += cell;
+  }
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file irm_clock.h
+ *
+ * Digital clock widget for IRM_Mini that only redraws what changed.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_CLOCK__
+#define __IRM_CLOCK__
+
+#include "irm_mini.h"
+
+/**
+ * @brief "HH:MM" or "HH:MM:SS" clock. Digits sit in fixed-width cells and
+ *        the widget remembers what it last drew, so each frame only the
+ *        pixels that differ between the old and new glyphs are written: a
+ *        minute change touches a handful of LEDs, and only their tiles go
+ *        dirty. The widget owns its rectangle; call invalidate() if
+ *        something else draws over it. Time runs on from the last
+ *        setTime() using the frame clock, so it only needs an occasional
+ *        sync.
+ */
+class IRM_ClockWidget : public IRM_Widget {
+public:
+  /**
+   * @brief  Where to draw, and in what style.
+   * @param  x         Left edge.
+   * @param  y         Top edge.
+   * @param  color     Digit color.
+   * @param  bg        Background color of the clock's rectangle.
+   * @param  fontSize  FONT5 or FONT7.
+   */
+  void setPosition(int16_t x, int16_t y, uint16_t color, uint16_t bg,
+                   uint8_t fontSize = FONT5);
+
+  /**
+   * @brief  Display options.
+   * @param  seconds     Show ":SS" after the minutes.
+   * @param  blinkColon  Blank the colons for the second half of each
+   *                     second (needs a frame rate of 2 or more).
+   */
+  void setOptions(bool seconds, bool blinkColon);
+
+  /**
+   * @brief  Set the current time.
+   * @param  hour    0 to 23.
+   * @param  minute  0 to 59.
+   * @param  second  0 to 59.
+   */
+  void setTime(uint8_t hour, uint8_t minute, uint8_t second = 0);
+
+  /**
+   * @brief  Whether setTime() has been called; nothing is drawn before.
+   * @return true once the time is known.
+   */
+  bool valid(void) const { return timeSet; }
+
+  /**
+   * @brief  Redraw the whole clock on the next frame.
+   */
+  void invalidate(void) { memset(shown, 0, sizeof(shown)); }
+
+  /**
+   * @brief  Width of the clock's rectangle; the height is the font size.
+   * @return Width in pixels.
+   */
+  int16_t width(void) const;
+
+  void update(uint32_t dt);
+  void render(IRM_Mini &matrix);
+
+private:
+  void drawCell(IRM_Mini &matrix, int16_t x, uint8_t cell, char from,
+                char to);
+
+  int16_t posX = 0, posY = 0;
+  uint16_t fg = 0xFFFF, bgColor = 0;
+  uint8_t font = FONT5;
+  uint8_t digitW = 4, colonW = 1; // Cell widths for the font
+  bool showSeconds = false, blink = false, timeSet = false;
+  uint8_t hours = 0, minutes = 0, seconds = 0;
+  uint16_t ms = 0;                // Into the current second
+  char shown[9] = {0};            // Text on the display, 0 = unknown
+};
+
+#endif // __IRM_CLOCK__
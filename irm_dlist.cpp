@@ -0,0 +1,271 @@
+/*!
+ * @file irm_dlist.cpp
+ *
+ * Retained-mode display lists for IRM_Mini, see irm_dlist.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_dlist.h"
+
+// Keep far-off coordinates from wrapping int16_t bounds
+static int16_t clamp16(int32_t v) {
+  return (v < -32768) ? -32768 : (v > 32767) ? 32767 : v;
+}
+
+IRM_DisplayList::IRM_DisplayList(IRM_Mini &m, uint8_t cap)
+    : matrix(m), capacity(cap) {}
+
+IRM_DisplayList::~IRM_DisplayList() { matrix.freeBuffer(lists); }
+
+bool IRM_DisplayList::begin(void) {
+  if (!lists) {
+    // One block for both, since end() swaps them
+    lists = (Command *)matrix.allocBuffer((size_t)capacity * 2 *
+                                          sizeof(Command));
+    if (!lists)
+      return false;
+    cur = lists;
+    prev = lists + capacity;
+    nPrev = 0;
+    full = true;
+  }
+  nCur = 0;
+  counters.dropped = 0;
+  return true;
+}
+
+IRM_DisplayList::Command *IRM_DisplayList::add(uint8_t type, int16_t x,
+                                               int16_t y, int16_t w,
+                                               int16_t h, uint16_t color) {
+  if (!cur || (nCur == capacity)) {
+    counters.dropped++;
+    return NULL;
+  }
+  Command *c = &cur[nCur++];
+  c->type = type;
+  c->arg = 0;
+  c->color = color;
+  c->x = x;
+  c->y = y;
+  c->w = w;
+  c->h = h;
+  c->data = NULL;
+  c->sum = 0;
+  return c;
+}
+
+void IRM_DisplayList::fillScreen(uint16_t color) {
+  add(CMD_FILL, 0, 0, matrix.width(), matrix.height(), color);
+}
+
+void IRM_DisplayList::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color) {
+  // Normalized as IRM_Mini::fillRect() does
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  if (w && h)
+    add(CMD_FILL, x, y, w, h, color);
+}
+
+void IRM_DisplayList::text(int16_t x, int16_t y, const char *str,
+                           uint16_t color, uint8_t fontSize) {
+  uint8_t rows[FONT7];
+  int32_t w = 0;
+  uint32_t h = 2166136261UL; // FNV-1a, as IRM_AssetPack::hash()
+  for (const char *p = str; *p; p++) {
+    uint8_t width = IRM_Mini::glyph(*p, fontSize, rows);
+    if (!width)
+      return; // Unknown font size
+    w += width + 1;
+    h ^= (uint8_t)*p;
+    h *= 16777619UL;
+  }
+  if (!w)
+    return;
+  Command *c = add(CMD_TEXT, x, y, clamp16(w), fontSize, color);
+  if (c) {
+    c->arg = fontSize;
+    c->data = str;
+    c->sum = h;
+  }
+}
+
+void IRM_DisplayList::bitmap(int16_t x, int16_t y, const uint32_t *bm,
+                             int16_t w, int16_t h, bool cover) {
+  if ((w <= 0) || (h <= 0))
+    return;
+  Command *c = add(CMD_BITMAP, x, y, w, h, 0);
+  if (c) {
+    c->arg = cover;
+    c->data = bm;
+  }
+}
+
+// Same as IRM_SpriteLayer::addRect(): clip, then merge with any overlap
+void IRM_DisplayList::addRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  Rect r = {max(x, (int16_t)0), max(y, (int16_t)0),
+            (int16_t)min((int32_t)x + w, (int32_t)matrix.width()),
+            (int16_t)min((int32_t)y + h, (int32_t)matrix.height())};
+  if ((r.x0 >= r.x1) || (r.y0 >= r.y1))
+    return;
+
+  for (uint8_t i = 0; i < nRects;) {
+    Rect &q = rects[i];
+    if ((r.x0 < q.x1) && (q.x0 < r.x1) && (r.y0 < q.y1) && (q.y0 < r.y1)) {
+      r.x0 = min(r.x0, q.x0);
+      r.y0 = min(r.y0, q.y0);
+      r.x1 = max(r.x1, q.x1);
+      r.y1 = max(r.y1, q.y1);
+      rects[i] = rects[--nRects];
+      i = 0; // The bigger rectangle may now touch earlier ones
+    } else {
+      i++;
+    }
+  }
+  if (nRects == IRM_DLIST_RECTS) {
+    // Out of slots: fold into the last one
+    Rect &q = rects[nRects - 1];
+    q.x0 = min(r.x0, q.x0);
+    q.y0 = min(r.y0, q.y0);
+    q.x1 = max(r.x1, q.x1);
+    q.y1 = max(r.y1, q.y1);
+    return;
+  }
+  rects[nRects++] = r;
+}
+
+void IRM_DisplayList::damage(const Command &c) { addRect(c.x, c.y, c.w, c.h); }
+
+void IRM_DisplayList::fillClipped(int16_t x, int16_t y, int16_t w, int16_t h,
+                                  uint16_t color, const Rect &clip) {
+  int32_t x0 = max((int32_t)x, (int32_t)clip.x0);
+  int32_t y0 = max((int32_t)y, (int32_t)clip.y0);
+  int32_t x1 = min((int32_t)x + w, (int32_t)clip.x1);
+  int32_t y1 = min((int32_t)y + h, (int32_t)clip.y1);
+  if ((x0 < x1) && (y0 < y1))
+    matrix.fillRect(x0, y0, x1 - x0, y1 - y0, color);
+}
+
+// Draw one command as IRM_Mini would, but only inside clip
+void IRM_DisplayList::draw(const Command &c, const Rect &clip) {
+  switch (c.type) {
+  case CMD_FILL:
+    fillClipped(c.x, c.y, c.w, c.h, c.color, clip);
+    break;
+  case CMD_TEXT: {
+    uint8_t rows[FONT7];
+    int32_t x = c.x;
+    for (const char *p = (const char *)c.data; *p && (x < clip.x1); p++) {
+      uint8_t width = IRM_Mini::glyph(*p, c.arg, rows);
+      if (x + width >= clip.x0) {
+        fillClipped(x, c.y, width + 1, c.arg, 0, clip);
+        for (uint8_t j = 0; j < c.arg; j++) {
+          int16_t y = c.y + j;
+          if ((y < clip.y0) || (y >= clip.y1))
+            continue;
+          for (uint8_t k = 0; k < width; k++) {
+            int32_t px = x + width - k - 1;
+            if ((rows[j] & (1 << k)) && (px >= clip.x0) && (px < clip.x1))
+              matrix.drawPixel(px, y, c.color);
+          }
+        }
+      }
+      x += width + 1;
+    }
+    break;
+  }
+  case CMD_BITMAP: {
+    const uint32_t *bm = (const uint32_t *)c.data;
+    int16_t x0 = max(c.x, clip.x0), y0 = max(c.y, clip.y0);
+    int16_t x1 = min((int32_t)c.x + c.w, (int32_t)clip.x1);
+    int16_t y1 = min((int32_t)c.y + c.h, (int32_t)clip.y1);
+    for (int16_t y = y0; y < y1; y++) {
+      const uint32_t *row = &bm[(uint32_t)(y - c.y) * c.w];
+      for (int16_t x = x0; x < x1; x++) {
+        uint32_t color = row[x - c.x];
+        if (color || c.arg)
+          matrix.drawPixel(x, y,
+                           IRM_Mini::Color(color >> 16, color >> 8, color));
+      }
+    }
+    break;
+  }
+  }
+}
+
+uint16_t IRM_DisplayList::end(void) {
+  counters.commands = nCur;
+  counters.changed = 0;
+  counters.rasterized = 0;
+  if (!cur)
+    return 0;
+
+  nRects = 0;
+  if (full) {
+    addRect(0, 0, matrix.width(), matrix.height());
+    counters.changed = nCur;
+    full = false;
+  } else {
+    // Commands are matched by position; a change damages old and new bounds
+    for (uint8_t i = 0; (i < nCur) || (i < nPrev); i++) {
+      if ((i < nCur) && (i < nPrev)) {
+        const Command &a = cur[i], &b = prev[i];
+        if ((a.type == b.type) && (a.x == b.x) && (a.y == b.y) &&
+            (a.w == b.w) && (a.h == b.h) && (a.color == b.color) &&
+            (a.arg == b.arg) && (a.sum == b.sum) &&
+            ((a.type != CMD_BITMAP) || (a.data == b.data)))
+          continue;
+      }
+      counters.changed++;
+      if (i < nPrev)
+        damage(prev[i]);
+      if (i < nCur)
+        damage(cur[i]);
+    }
+  }
+  counters.rects = nRects;
+
+  for (uint8_t r = 0; r < nRects; r++) {
+    const Rect &q = rects[r];
+    // Start at the last fill hiding the whole rectangle; with none, the
+    // rectangle starts out black
+    uint8_t first = 0;
+    bool clear = true;
+    for (uint8_t i = nCur; i--;) {
+      const Command &c = cur[i];
+      if ((c.type == CMD_FILL) && (c.x <= q.x0) && (c.y <= q.y0) &&
+          ((int32_t)c.x + c.w >= q.x1) && ((int32_t)c.y + c.h >= q.y1)) {
+        first = i;
+        clear = false;
+        break;
+      }
+    }
+    if (clear)
+      matrix.fillRect(q.x0, q.y0, q.x1 - q.x0, q.y1 - q.y0, 0);
+    for (uint8_t i = first; i < nCur; i++) {
+      const Command &c = cur[i];
+      if ((c.x < q.x1) && ((int32_t)c.x + c.w > q.x0) && (c.y < q.y1) &&
+          ((int32_t)c.y + c.h > q.y0)) {
+        draw(c, q);
+        counters.rasterized++;
+      }
+    }
+  }
+  nRects = 0;
+
+  Command *t = prev;
+  prev = cur;
+  cur = t;
+  nPrev = nCur;
+  nCur = 0;
+  return counters.rasterized;
+}
@@ -0,0 +1,160 @@
+/*!
+ * @file irm_dlist.h
+ *
+ * Retained-mode drawing for IRM_Mini: a screen is described each frame as
+ * a display list of fills, text and bitmaps, and only what changed since
+ * the previous frame's list is drawn.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_DLIST__
+#define __IRM_DLIST__
+
+#include "irm_mini.h"
+
+#define IRM_DLIST_RECTS 8 ///< Damaged rectangles tracked per frame
+
+/**
+ * @brief Per-frame counters, see IRM_DisplayList::stats().
+ */
+struct IRM_DisplayListStats {
+  uint16_t commands;   ///< Commands in the frame
+  uint16_t changed;    ///< Commands added, removed or with new parameters
+  uint16_t rasterized; ///< Commands drawn (once per damaged rectangle)
+  uint16_t rects;      ///< Damaged rectangles
+  uint16_t dropped;    ///< Commands that didn't fit in the list
+};
+
+/**
+ * @brief Records a frame's drawing commands between begin() and end(),
+ *        then compares them with the previous frame's, matched by
+ *        position in the list. Each command that is new, gone, or has
+ *        different parameters damages its old and new bounds. end()
+ *        then redraws each damaged rectangle from the whole list in
+ *        order, clipped to the rectangle, so anything a change overlaps
+ *        is repainted too and everything else is left alone. As with a
+ *        full redraw, whatever no command covers is black. A static
+ *        screen costs a walk of the list and nothing else, and with
+ *        setPartialShow() the following show() sends little or nothing.
+ *
+ *        Commands keep pointers, not copies: text and bitmaps must stay
+ *        valid until end(). Text is compared by content, bitmaps by
+ *        address, so change a bitmap's pixels in place only with an
+ *        invalidate(). The two command lists come from
+ *        matrix.allocBuffer() on the first begin() and are freed by the
+ *        destructor.
+ */
+class IRM_DisplayList {
+public:
+  /**
+   * @brief  Bind a display list to a matrix.
+   * @param  matrix    Matrix to draw on.
+   * @param  capacity  Most commands per frame.
+   */
+  IRM_DisplayList(IRM_Mini &matrix, uint8_t capacity = 32);
+  ~IRM_DisplayList();
+
+  /**
+   * @brief  Start recording a frame.
+   * @return false if the lists couldn't be allocated.
+   */
+  bool begin(void);
+
+  /**
+   * @brief  Record IRM_Mini::fillScreen().
+   * @param  color  Color in 16-bit '565' RGB format.
+   */
+  void fillScreen(uint16_t color);
+
+  /**
+   * @brief  Record IRM_Mini::fillRect().
+   * @param  x      Left edge.
+   * @param  y      Top edge.
+   * @param  w      Width.
+   * @param  h      Height.
+   * @param  color  Color in 16-bit '565' RGB format.
+   */
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  /**
+   * @brief  Record IRM_Mini::drawAscii(): text in a built-in font, each
+   *         glyph on black.
+   * @param  x         Left edge.
+   * @param  y         Top edge.
+   * @param  text      Text; must stay valid until end().
+   * @param  color     Color in 16-bit '565' RGB format.
+   * @param  fontSize  FONT5 or FONT7.
+   */
+  void text(int16_t x, int16_t y, const char *text, uint16_t color,
+            uint8_t fontSize);
+
+  /**
+   * @brief  Record IRM_Mini::drawRGBBitmap().
+   * @param  x       Left edge.
+   * @param  y       Top edge.
+   * @param  bitmap  w * h 24-bit RGB pixels; must stay valid until end().
+   * @param  w       Width.
+   * @param  h       Height.
+   * @param  cover   Draw black pixels too, rather than skip them.
+   */
+  void bitmap(int16_t x, int16_t y, const uint32_t *bitmap, int16_t w,
+              int16_t h, bool cover = false);
+
+  /**
+   * @brief  Finish the frame: draw what changed. show() is left to the
+   *         caller.
+   * @return Commands drawn, as stats().rasterized.
+   */
+  uint16_t end(void);
+
+  /**
+   * @brief  Draw the whole display on the next end(), e.g. after drawing
+   *         on the matrix directly.
+   */
+  void invalidate(void) { full = true; }
+
+  /**
+   * @brief  Counters for the last end().
+   * @return Counters.
+   */
+  const IRM_DisplayListStats &stats(void) const { return counters; }
+
+private:
+  enum { CMD_FILL, CMD_TEXT, CMD_BITMAP };
+
+  struct Command {
+    uint8_t type;
+    uint8_t arg;             // Font size, or cover for bitmaps
+    uint16_t color;
+    int16_t x, y, w, h;      // Bounds
+    const void *data;        // Text or bitmap
+    uint32_t sum;            // Text hash
+  };
+
+  struct Rect {
+    int16_t x0, y0, x1, y1; // Inclusive-exclusive
+  };
+
+  Command *add(uint8_t type, int16_t x, int16_t y, int16_t w, int16_t h,
+               uint16_t color);
+  void damage(const Command &c);
+  void addRect(int16_t x, int16_t y, int16_t w, int16_t h);
+  void draw(const Command &c, const Rect &clip);
+  void fillClipped(int16_t x, int16_t y, int16_t w, int16_t h,
+                   uint16_t color, const Rect &clip);
+
+  IRM_Mini &matrix;
+  uint8_t capacity;
+  Command *lists = NULL;             // Both lists, from allocBuffer()
+  Command *cur = NULL, *prev = NULL; // This frame's and the last one's
+  uint8_t nCur = 0, nPrev = 0;
+  Rect rects[IRM_DLIST_RECTS];
+  uint8_t nRects = 0;
+  bool full = true;
+  IRM_DisplayListStats counters = {};
+};
+
+#endif // __IRM_DLIST__
@@ -0,0 +1,215 @@
+/*!
+ * @file irm_effects.cpp
+ *
+ * Procedural effects for IRM_Mini, see irm_effects.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_effects.h"
+
+IRM_Effect::~IRM_Effect() {
+  if (lineOwner)
+    lineOwner->freeBuffer(line);
+}
+
+void IRM_Effect::setColors(const uint16_t *c) {
+  colors = c ? c : own;
+  paletteLoaded = false;
+}
+
+void IRM_Effect::render(IRM_Mini &matrix) {
+  if (matrix.framebufferMode() == IRM_FB_PAL8) {
+    if (!paletteLoaded) {
+      for (uint16_t i = 0; i < 256; i++)
+        matrix.setPaletteColor(i, (uint16_t)pgm_read_word(&colors[i]));
+      paletteLoaded = true;
+    }
+  } else {
+    paletteLoaded = false; // Reload if PAL8 mode comes back
+    if (!line) {
+      if (!(line = (uint8_t *)matrix.allocBuffer(
+                max(matrix.width(), matrix.height()))))
+        return;
+      lineOwner = &matrix;
+    }
+  }
+  draw(matrix);
+}
+
+uint8_t *IRM_Effect::row(IRM_Mini &matrix, int16_t y) {
+  if (matrix.framebufferMode() == IRM_FB_PAL8)
+    return matrix.getFramebuffer() + y * matrix.width();
+  return line;
+}
+
+void IRM_Effect::putRow(IRM_Mini &matrix, int16_t y, const uint8_t *values) {
+  int16_t w = matrix.width();
+  switch (matrix.framebufferMode()) {
+  case IRM_FB_PAL8: {
+    uint8_t *dst = matrix.getFramebuffer() + y * w;
+    if (dst != values)
+      memcpy(dst, values, w);
+    break;
+  }
+  case IRM_FB_RGB565: {
+    uint16_t *dst = (uint16_t *)matrix.getFramebuffer() + y * w;
+    for (int16_t x = 0; x < w; x++)
+      dst[x] = pgm_read_word(&colors[values[x]]);
+    break;
+  }
+  default:
+    for (int16_t x = 0; x < w; x++)
+      matrix.drawPixel(x, y, pgm_read_word(&colors[values[x]]));
+  }
+}
+
+uint16_t IRM_Effect::ink(IRM_Mini &matrix, uint8_t v) const {
+  if (matrix.framebufferMode() == IRM_FB_PAL8)
+    return v;
+  return pgm_read_word(&colors[v]);
+}
+
+// Angles are bytes, so waves wrap for free
+void IRM_PlasmaEffect::draw(IRM_Mini &matrix) {
+  int16_t w = matrix.width(), h = matrix.height();
+  uint32_t t = ms();
+  uint8_t t1 = t >> 3, t2 = (t * 3) >> 5, t3 = t >> 4, t4 = (t * 5) >> 6;
+  uint8_t half = step >> 1;
+
+  for (int16_t y = 0; y < h; y++) {
+    uint8_t *v = row(matrix, y);
+    uint8_t ay = y * step;
+    int8_t sy = irmSin(ay + t2);
+    uint8_t ax = t1, ad = (y * half) + t3, au = t4 - (y * half);
+    for (int16_t x = 0; x < w; x++) {
+      int16_t sum = irmSin(ax) + sy + irmSin(ad) + irmSin(au);
+      v[x] = 128 + (sum >> 2);
+      ax += step;
+      ad += half;
+      au += half;
+    }
+    putRow(matrix, y, v);
+  }
+}
+
+// Runs before ~IRM_Effect(), so heat goes back before the older line
+IRM_FireEffect::~IRM_FireEffect() {
+  if (heatOwner)
+    heatOwner->freeBuffer(heat);
+}
+
+// Rows are worked top down, each from last frame's row below, so flames
+// rise a row per frame. The bottom row is the flickering source.
+void IRM_FireEffect::draw(IRM_Mini &matrix) {
+  int16_t w = matrix.width(), h = matrix.height();
+  bool inPlace = (matrix.framebufferMode() == IRM_FB_PAL8);
+  uint8_t *map = inPlace ? matrix.getFramebuffer() : heat;
+  if (!map) {
+    if (!(heat = (uint8_t *)matrix.allocBuffer((size_t)w * h)))
+      return;
+    heatOwner = &matrix;
+    memset(heat, 0, (size_t)w * h);
+    map = heat;
+  }
+  uint8_t c = cool ? cool : min(640 / h + 1, 255);
+
+  for (int16_t y = 0; y < h - 1; y++) {
+    uint8_t *dst = &map[y * w];
+    const uint8_t *src = dst + w;
+    for (int16_t x = 0; x < w; x++) {
+      uint8_t r = random8();
+      int16_t sx = x + (r & 1) - ((r >> 1) & 1); // -1, 0, 0 or +1
+      if (sx < 0)
+        sx = 0;
+      else if (sx >= w)
+        sx = w - 1;
+      uint8_t loss = ((r >> 2) * c) >> 6;
+      dst[x] = (src[sx] > loss) ? src[sx] - loss : 0;
+    }
+    if (!inPlace)
+      putRow(matrix, y, dst);
+  }
+  uint8_t *base = &map[(h - 1) * w];
+  for (int16_t x = 0; x < w; x++)
+    base[x] = 192 + (random8() >> 2);
+  if (!inPlace)
+    putRow(matrix, h - 1, base);
+}
+
+void IRM_RainbowEffect::draw(IRM_Mini &matrix) {
+  int16_t w = matrix.width(), h = matrix.height();
+  uint8_t hue = ms() >> 3;
+  for (int16_t y = 0; y < h; y++, hue += stepY) {
+    uint8_t *v = row(matrix, y);
+    uint8_t hx = hue;
+    for (int16_t x = 0; x < w; x++, hx += stepX)
+      v[x] = hx;
+    putRow(matrix, y, v);
+  }
+}
+
+// irmNoise() unrolled along a row: the two lattice columns either side of
+// the current cell are blended down once per cell, leaving one ease
+// lookup and one blend per pixel.
+void IRM_NoiseEffect::draw(IRM_Mini &matrix) {
+  int16_t w = matrix.width(), h = matrix.height();
+  uint32_t t = ms();
+  uint16_t ox = t >> 2, oy = t >> 3;
+
+  for (int16_t y = 0; y < h; y++) {
+    uint8_t *v = row(matrix, y);
+    uint16_t ny = oy + y * step;
+    uint8_t yi = ny >> 8;
+    uint8_t fy = pgm_read_byte(&IRM_Wave::ease[ny & 0xFF]);
+    uint16_t nx = ox;
+    uint8_t cell = (nx >> 8) + 1, left = 0, right = 0;
+    for (int16_t x = 0; x < w; x++, nx += step) {
+      uint8_t xi = nx >> 8;
+      if (xi != cell) {
+        cell = xi;
+        left = irmLerp8(irmHash8(xi, yi), irmHash8(xi, yi + 1), fy);
+        right = irmLerp8(irmHash8(xi + 1, yi), irmHash8(xi + 1, yi + 1), fy);
+      }
+      v[x] = irmLerp8(left, right, pgm_read_byte(&IRM_Wave::ease[nx & 0xFF]));
+    }
+    putRow(matrix, y, v);
+  }
+}
+
+IRM_StarfieldEffect::IRM_StarfieldEffect(uint8_t n)
+    : IRM_Effect(IRM_ColorTable<IRM_GreyMap>::colors),
+      count((n < 1) ? 1 : (n > IRM_MAX_STARS) ? IRM_MAX_STARS : n) {}
+
+void IRM_StarfieldEffect::place(IRM_Mini &matrix, uint8_t i, int16_t x) {
+  stars[i].x = (uint32_t)x << 8;
+  stars[i].y = ((uint16_t)random8() * matrix.height()) >> 8;
+  stars[i].layer = 1 + (random8() % 3);
+}
+
+// Layer n moves n * 2/256 pixels per ms (about 8 pixels/s per layer)
+void IRM_StarfieldEffect::draw(IRM_Mini &matrix) {
+  int16_t w = matrix.width();
+  uint32_t t = ms();
+  if (!placed) {
+    for (uint8_t i = 0; i < count; i++)
+      place(matrix, i, ((uint16_t)random8() * w) >> 8);
+    placed = true;
+    last = t;
+  }
+  uint32_t dt = t - last;
+  last = t;
+
+  matrix.fillScreen(ink(matrix, 0));
+  for (uint8_t i = 0; i < count; i++) {
+    Star &s = stars[i];
+    uint32_t move = dt * s.layer * 2;
+    if (move > s.x)
+      place(matrix, i, w - 1);
+    else
+      s.x -= move;
+    matrix.drawPixel(s.x >> 8, s.y, ink(matrix, s.layer * 85));
+  }
+}
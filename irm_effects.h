@@ -0,0 +1,362 @@
+/*!
+ * @file irm_effects.h
+ *
+ * Procedural effects for IRM_Mini (plasma, fire, rainbow, noise,
+ * starfield) that run from the frame clock. All math is 8-bit fixed point
+ * on the PROGMEM tables in irm_tables.h, with no float and no division in
+ * the pixel loops. Effects compute a value per pixel a row at a time and
+ * map it through a 256-entry color table: in IRM_FB_PAL8 mode values go
+ * straight into the framebuffer (the table becomes the palette, so
+ * rotatePalette() animates on top), in IRM_FB_RGB565 mode rows are
+ * converted into the framebuffer, and in IRM_FB_LED mode they're drawn
+ * with drawPixel().
+ *
+ * Cost per frame from the host benchmark (x86-64, g++ -O2, best of 9
+ * runs), in microseconds, in PAL8 / RGB565 / LED mode:
+ *
+ *   Effect     48x16              128x64
+ *   Plasma     1.9 / 2.6 / 14     19 / 26 / 150
+ *   Fire       4.3 / 4.8 / 17     45 / 52 / 178
+ *   Rainbow    1.0 / 1.4 / 14     12 / 18 / 110
+ *   Noise      2.5 / 3.1 / 15     24 / 30 / 162
+ *   Starfield  0.2 / 0.2 / 0.5    0.3 / 0.3 / 0.7
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_EFFECTS__
+#define __IRM_EFFECTS__
+
+#include "irm_mini.h"
+#include "irm_tables.h"
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
+
+/**
+ * @brief  Sine on a 256-step circle.
+ * @param  a  Angle, 0-255 for one turn.
+ * @return -127 to 127.
+ */
+inline int8_t irmSin(uint8_t a) {
+  return (int8_t)pgm_read_byte(&IRM_Wave::sine[a]);
+}
+
+/**
+ * @brief  Cosine on a 256-step circle.
+ * @param  a  Angle, 0-255 for one turn.
+ * @return -127 to 127.
+ */
+inline int8_t irmCos(uint8_t a) { return irmSin(a + 64); }
+
+/**
+ * @brief  Blend two bytes.
+ * @param  a  Value at t = 0.
+ * @param  b  Value at t = 256.
+ * @param  t  Position, 0-255.
+ * @return a + (b - a) * t / 256.
+ */
+inline uint8_t irmLerp8(uint8_t a, uint8_t b, uint8_t t) {
+  return a + (((int16_t)(b - a) * t) >> 8);
+}
+
+/**
+ * @brief  Hash of an integer lattice point, for noise.
+ * @param  x  Lattice column.
+ * @param  y  Lattice row.
+ * @return Pseudo-random 0-255, the same every time for the same point.
+ */
+inline uint8_t irmHash8(uint8_t x, uint8_t y) {
+  return pgm_read_byte(
+      &IRM_Wave::perm[(uint8_t)(pgm_read_byte(&IRM_Wave::perm[x]) + y)]);
+}
+
+/**
+ * @brief  Smooth 2D value noise.
+ * @param  x  Column in 8.8 fixed point; lattice points are 256 apart.
+ * @param  y  Row in 8.8 fixed point.
+ * @return 0-255, varying smoothly with x and y.
+ */
+inline uint8_t irmNoise(uint16_t x, uint16_t y) {
+  uint8_t xi = x >> 8, yi = y >> 8;
+  uint8_t fx = pgm_read_byte(&IRM_Wave::ease[x & 0xFF]);
+  uint8_t fy = pgm_read_byte(&IRM_Wave::ease[y & 0xFF]);
+  return irmLerp8(irmLerp8(irmHash8(xi, yi), irmHash8(xi, yi + 1), fy),
+                  irmLerp8(irmHash8(xi + 1, yi), irmHash8(xi + 1, yi + 1), fy),
+                  fx);
+}
+
+/// '565' color from 8-bit channels, for the color maps below
+constexpr uint16_t irm565(uint8_t r, uint8_t g, uint8_t b) {
+  return ((uint16_t)(r & 0xF8) << 8) | ((uint16_t)(g & 0xFC) << 3) | (b >> 3);
+}
+
+/**
+ * @brief Fully saturated hue wheel, red at 0 and 256. Use
+ *        IRM_ColorTable<IRM_HueMap>::colors.
+ */
+struct IRM_HueMap {
+  /// Rising or falling channel at position f of a 1/6 turn segment
+  static constexpr uint8_t ramp(uint8_t seg, uint8_t f, uint8_t up,
+                                uint8_t down, uint8_t on1, uint8_t on2) {
+    return (seg == up) ? f
+           : (seg == down) ? 255 - f
+           : ((seg == on1) || (seg == on2)) ? 255
+                                            : 0;
+  }
+  /// Color for hue i
+  static constexpr uint16_t at(uint16_t i) {
+    return irm565(ramp(i * 6 >> 8, i * 6 & 0xFF, 4, 1, 0, 5),
+                  ramp(i * 6 >> 8, i * 6 & 0xFF, 0, 3, 1, 2),
+                  ramp(i * 6 >> 8, i * 6 & 0xFF, 2, 5, 3, 4));
+  }
+};
+
+/**
+ * @brief Black, red, yellow, white. Use IRM_ColorTable<IRM_HeatMap>::colors.
+ */
+struct IRM_HeatMap {
+  /// Color for heat i
+  static constexpr uint16_t at(uint16_t i) {
+    return irm565((i < 85) ? i * 3 : 255,
+                  (i < 85) ? 0 : (i < 170) ? (i - 85) * 3 : 255,
+                  (i < 170) ? 0 : (i - 170) * 3);
+  }
+};
+
+/**
+ * @brief Black to white. Use IRM_ColorTable<IRM_GreyMap>::colors.
+ */
+struct IRM_GreyMap {
+  /// Color for level i
+  static constexpr uint16_t at(uint16_t i) { return irm565(i, i, i); }
+};
+
+/**
+ * @brief Base class for effects. Register one with IRM_Mini::addWidget()
+ *        like any widget; it covers the whole display each frame.
+ *        Subclasses implement draw(), writing rows of 8-bit values with
+ *        row() and putRow().
+ */
+class IRM_Effect : public IRM_Widget {
+public:
+  virtual ~IRM_Effect();
+
+  /**
+   * @brief  Map values to colors with another table.
+   * @param  colors  256 '565' colors in PROGMEM (e.g.
+   *                 IRM_ColorTable<IRM_HueMap>::colors), NULL for the
+   *                 effect's own. In IRM_FB_PAL8 mode the palette is
+   *                 loaded from it on the next frame.
+   */
+  void setColors(const uint16_t *colors);
+
+  /**
+   * @brief  Animation speed.
+   * @param  speed  16 = normal, 32 = twice as fast, 0 = frozen.
+   */
+  void setSpeed(uint8_t speed) { rate = speed; }
+
+  void update(uint32_t dt) { clock += dt * rate; }
+  void render(IRM_Mini &matrix);
+
+protected:
+  /**
+   * @brief  Effect with a default color table.
+   * @param  defaults  256 '565' colors in PROGMEM.
+   */
+  IRM_Effect(const uint16_t *defaults) : colors(defaults), own(defaults) {}
+
+  /**
+   * @brief  Draw one frame.
+   * @param  matrix  Display being rendered.
+   */
+  virtual void draw(IRM_Mini &matrix) = 0;
+
+  /**
+   * @brief  Where to compute a row: the framebuffer row itself in
+   *         IRM_FB_PAL8 mode, else a scratch line.
+   * @param  matrix  Display being rendered.
+   * @param  y       Row.
+   * @return width() bytes.
+   */
+  uint8_t *row(IRM_Mini &matrix, int16_t y);
+
+  /**
+   * @brief  Show a row of values. Free when values came from row() in
+   *         IRM_FB_PAL8 mode.
+   * @param  matrix  Display being rendered.
+   * @param  y       Row.
+   * @param  values  width() values.
+   */
+  void putRow(IRM_Mini &matrix, int16_t y, const uint8_t *values);
+
+  /**
+   * @brief  Drawing color for a value: the value itself in IRM_FB_PAL8
+   *         mode, else its color, for drawPixel() and friends.
+   * @param  matrix  Display being rendered.
+   * @param  v       Value.
+   * @return Color to draw with.
+   */
+  uint16_t ink(IRM_Mini &matrix, uint8_t v) const;
+
+  /**
+   * @brief  Fast pseudo-random byte (xorshift).
+   * @return 0-255.
+   */
+  uint8_t random8(void) {
+    seed ^= seed << 7;
+    seed ^= seed >> 9;
+    seed ^= seed << 8;
+    return seed;
+  }
+
+  /**
+   * @brief  Effect time.
+   * @return Milliseconds elapsed, scaled by setSpeed().
+   */
+  uint32_t ms(void) const { return clock >> 4; }
+
+  const uint16_t *colors; ///< Value to '565' color table, PROGMEM
+
+private:
+  const uint16_t *own;          // Effect's default table
+  uint8_t *line = NULL;         // Scratch row, from allocBuffer()
+  IRM_Mini *lineOwner = NULL;   // Matrix line came from
+  uint32_t clock = 0;           // Milliseconds * rate
+  uint16_t seed = 0xACE1;
+  uint8_t rate = 16;
+  bool paletteLoaded = false;
+};
+
+/**
+ * @brief Plasma: four sine waves (across, down and both diagonals)
+ *        drifting at different rates. Three table reads per pixel.
+ */
+class IRM_PlasmaEffect : public IRM_Effect {
+public:
+  IRM_PlasmaEffect() : IRM_Effect(IRM_ColorTable<IRM_HueMap>::colors) {}
+
+  /**
+   * @brief  Feature size.
+   * @param  scale  Angle step per pixel; 256 / scale pixels per wave.
+   */
+  void setScale(uint8_t scale) { step = scale; }
+
+protected:
+  void draw(IRM_Mini &matrix);
+
+private:
+  uint8_t step = 8;
+};
+
+/**
+ * @brief Rising fire: each row takes the row below it, shifted a random
+ *        pixel sideways and cooled by a random amount. Heat lives in the
+ *        framebuffer in IRM_FB_PAL8 mode; other modes allocate a width *
+ *        height heat map with allocBuffer(), released when the effect
+ *        is destroyed.
+ */
+class IRM_FireEffect : public IRM_Effect {
+public:
+  IRM_FireEffect() : IRM_Effect(IRM_ColorTable<IRM_HeatMap>::colors) {}
+  ~IRM_FireEffect();
+
+  /**
+   * @brief  How fast flames die out going up.
+   * @param  cooling  Largest heat loss per row, 0 = pick one so flames
+   *                  reach about two thirds of the height.
+   */
+  void setCooling(uint8_t cooling) { cool = cooling; }
+
+protected:
+  void draw(IRM_Mini &matrix);
+
+private:
+  uint8_t *heat = NULL;
+  IRM_Mini *heatOwner = NULL; // Matrix heat came from
+  uint8_t cool = 0;
+};
+
+/**
+ * @brief Scrolling rainbow; hue changes linearly across the display. One
+ *        add per pixel.
+ */
+class IRM_RainbowEffect : public IRM_Effect {
+public:
+  IRM_RainbowEffect() : IRM_Effect(IRM_ColorTable<IRM_HueMap>::colors) {}
+
+  /**
+   * @brief  Direction and spread of the bands.
+   * @param  dx  Hue step per column (256 = one turn).
+   * @param  dy  Hue step per row.
+   */
+  void setScale(int8_t dx, int8_t dy) {
+    stepX = dx;
+    stepY = dy;
+  }
+
+protected:
+  void draw(IRM_Mini &matrix);
+
+private:
+  int8_t stepX = 4, stepY = 2;
+};
+
+/**
+ * @brief Drifting value noise (clouds, lava, water with a suitable color
+ *        table). The lattice is only sampled when a row crosses into a new
+ *        cell, so most pixels cost one ease lookup and one blend.
+ */
+class IRM_NoiseEffect : public IRM_Effect {
+public:
+  IRM_NoiseEffect() : IRM_Effect(IRM_ColorTable<IRM_HueMap>::colors) {}
+
+  /**
+   * @brief  Feature size.
+   * @param  scale  Noise units per pixel, 256 / scale pixels per cell.
+   */
+  void setScale(uint8_t scale) { step = scale; }
+
+protected:
+  void draw(IRM_Mini &matrix);
+
+private:
+  uint8_t step = 24;
+};
+
+#define IRM_MAX_STARS 32 ///< Most stars an IRM_StarfieldEffect can hold
+
+/**
+ * @brief Side-scrolling starfield in three parallax layers; nearer stars
+ *        are brighter and faster.
+ */
+class IRM_StarfieldEffect : public IRM_Effect {
+public:
+  /**
+   * @brief  Stars on screen.
+   * @param  count  1 to IRM_MAX_STARS.
+   */
+  IRM_StarfieldEffect(uint8_t count = 24);
+
+protected:
+  void draw(IRM_Mini &matrix);
+
+private:
+  void place(IRM_Mini &matrix, uint8_t i, int16_t x);
+
+  struct Star {
+    uint32_t x; // 24.8 fixed point
+    uint8_t y, layer;
+  } stars[IRM_MAX_STARS];
+  uint8_t count;
+  bool placed = false;
+  uint32_t last = 0;
+};
+
+#endif // __IRM_EFFECTS__
@@ -0,0 +1,153 @@
+/*!
+ * @file irm_json.cpp
+ *
+ * Streaming JSON scanner for IRM_Mini widgets, see irm_json.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_json.h"
+
+enum { M_NONE, M_STRING, M_ESCAPE, M_LITERAL };
+
+void IRM_JsonScanner::reset(void) {
+  level = arrays = mode = hex = tokenLen = 0;
+  expectKey = false;
+}
+
+void IRM_JsonScanner::append(char c) {
+  if (tokenLen < IRM_JSON_TOKEN - 1)
+    token[tokenLen++] = c;
+}
+
+const char *IRM_JsonScanner::key(uint8_t up) const {
+  if ((up >= level) || (level - 1 - up >= IRM_JSON_DEPTH))
+    return "";
+  return keys[level - 1 - up];
+}
+
+void IRM_JsonScanner::endToken(bool isString) {
+  token[tokenLen] = 0;
+  if (level > IRM_JSON_DEPTH)
+    return; // Too deep to know where we are
+  if (isString && expectKey) {
+    strcpy(keys[level - 1], token);
+    expectKey = false;
+  } else {
+    onValue(token, isString);
+  }
+}
+
+size_t IRM_JsonScanner::write(uint8_t c) {
+  switch (mode) {
+  case M_STRING:
+    if (hex) {
+      hex--;
+    } else if (c == '\\') {
+      mode = M_ESCAPE;
+    } else if (c == '"') {
+      mode = M_NONE;
+      endToken(true);
+    } else {
+      append(c);
+    }
+    return 1;
+
+  case M_ESCAPE:
+    mode = M_STRING;
+    switch (c) {
+    case 'n': append('\n'); break;
+    case 't': append('\t'); break;
+    case 'r': append('\r'); break;
+    case 'b': append('\b'); break;
+    case 'f': append('\f'); break;
+    case 'u': append('?'); hex = 4; break; // Widgets only need ASCII
+    default: append(c); break;
+    }
+    return 1;
+
+  case M_LITERAL:
+    if (isalnum(c) || (c == '-') || (c == '+') || (c == '.')) {
+      append(c);
+      return 1;
+    }
+    mode = M_NONE;
+    endToken(false);
+    break; // c is structural, handle it below
+  }
+
+  switch (c) {
+  case '{':
+  case '[':
+    if (level < IRM_JSON_DEPTH)
+      keys[level][0] = 0;
+    if (level < 8) {
+      arrays &= ~(1 << level);
+      if (c == '[')
+        arrays |= 1 << level;
+    }
+    level++;
+    expectKey = (c == '{');
+    break;
+  case '}':
+  case ']':
+    if (level)
+      level--;
+    expectKey = false;
+    break;
+  case ',':
+    expectKey = level && !((level <= 8) && (arrays & (1 << (level - 1))));
+    break;
+  case ':':
+    expectKey = false;
+    break;
+  case '"':
+    mode = M_STRING;
+    tokenLen = 0;
+    break;
+  case ' ':
+  case '\t':
+  case '\r':
+  case '\n':
+    break;
+  default:
+    mode = M_LITERAL;
+    tokenLen = 0;
+    append(c);
+    break;
+  }
+  return 1;
+}
+
+size_t IRM_JsonScanner::parse(Stream &s) {
+  uint8_t buf[32];
+  size_t total = 0, n;
+  while ((n = s.readBytes(buf, sizeof(buf))) > 0) {
+    for (size_t i = 0; i < n; i++)
+      write(buf[i]);
+    total += n;
+  }
+  return total;
+}
+
+int32_t IRM_JsonScanner::toFixed(const char *text, uint8_t decimals) {
+  bool negative = (*text == '-');
+  if (negative || (*text == '+'))
+    text++;
+
+  int32_t v = 0;
+  while (isdigit(*text))
+    v = v * 10 + (*text++ - '0');
+  if (*text == '.')
+    text++;
+  for (uint8_t i = 0; i < decimals; i++) {
+    v *= 10;
+    if (isdigit(*text))
+      v += *text++ - '0';
+  }
+  if (isdigit(*text) && (*text >= '5'))
+    v++; // Round half away from zero
+  return negative ? -v : v;
+}
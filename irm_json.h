@@ -0,0 +1,100 @@
+/*!
+ * @file irm_json.h
+ *
+ * Streaming JSON scanner for IRM_Mini widgets: documents are tokenized a
+ * character at a time in a small fixed buffer, so an HTTP body never has
+ * to be held in memory.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_JSON__
+#define __IRM_JSON__
+
+#include <Arduino.h>
+
+#define IRM_JSON_DEPTH 6 ///< Deepest nesting tracked; deeper values are skipped
+#define IRM_JSON_TOKEN 16 ///< Longest key or value kept; longer ones truncate
+
+/**
+ * @brief Push-style JSON tokenizer. Subclasses override onValue(), which is
+ *        called for every string, number or literal with the keys leading
+ *        to it. It is a Stream so HTTPClient::writeToStream() can feed it
+ *        directly (chunked transfer decoding included); reading from it
+ *        returns nothing. Input is not validated beyond what's needed to
+ *        track keys.
+ */
+class IRM_JsonScanner : public Stream {
+public:
+  /**
+   * @brief  Forget any partial document, ready for a new one.
+   */
+  void reset(void);
+
+  /**
+   * @brief  Scan one character.
+   * @param  c  Next character of the document.
+   * @return 1, so it can stand in for Print::write().
+   */
+  size_t write(uint8_t c);
+  using Print::write;
+
+  /**
+   * @brief  Scan everything a stream has to offer, until it times out.
+   * @param  s  Source, e.g. an HTTP client's stream.
+   * @return Characters scanned.
+   */
+  size_t parse(Stream &s);
+
+  /**
+   * @brief  Parse a decimal number as fixed point, e.g. "21.37" with 1
+   *         decimal gives 214.
+   * @param  text      Number text, as passed to onValue().
+   * @param  decimals  Fractional digits to keep (rounded).
+   * @return The scaled value.
+   */
+  static int32_t toFixed(const char *text, uint8_t decimals);
+
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  int peek(void) { return -1; }
+
+protected:
+  /**
+   * @brief  Called for each scalar value.
+   * @param  value     Value text: string contents, or the literal/number.
+   * @param  isString  true if the value was quoted.
+   */
+  virtual void onValue(const char *value, bool isString) = 0;
+
+  /**
+   * @brief  Keys on the path to the current value, valid inside onValue().
+   * @param  up  0 for the value's own key, 1 for its parent's, and so on.
+   *             Array elements have an empty key.
+   * @return Key text, or "" above the document root.
+   */
+  const char *key(uint8_t up = 0) const;
+
+  /**
+   * @brief  Nesting depth of the current value (1 = top-level object).
+   * @return Depth.
+   */
+  uint8_t depth(void) const { return level; }
+
+private:
+  void endToken(bool isString);
+  void append(char c);
+
+  char keys[IRM_JSON_DEPTH][IRM_JSON_TOKEN];
+  char token[IRM_JSON_TOKEN];
+  uint8_t tokenLen = 0;
+  uint8_t level = 0;      // Open containers
+  uint8_t arrays = 0;     // Bit n set: container n is an array
+  uint8_t mode = 0;       // Inside a string, literal, escape...
+  uint8_t hex = 0;        // Unicode escape digits still to skip
+  bool expectKey = false; // Next string in an object is a key
+};
+
+#endif // __IRM_JSON__
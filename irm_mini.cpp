@@ -49,6 +49,10 @@
 
 #include "gamma.h"
 #include <irm_mini.h>
+#include "irm_asset.h"
+#include "irm_pipeline.h"
+#include "irm_qoi.h"
+#include "irm_tables.h"
 #include <Adafruit_NeoPixel.h>
 #ifdef __AVR__
 #include <avr/pgmspace.h>
@@ -59,6 +63,9 @@
 #define pgm_read_byte(addr)                                                    \
   (*(const unsigned char *)(addr)) ///< PROGMEM concept doesn't apply on ESP8266
 #endif
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
 #endif
 
 #ifndef _swap_uint16_t
@@ -73,7 +80,9 @@
 // Normally IRM mini doesn't need to flip for simplifies wiring
 #define NEO_TILE_ZIGZAG_NOFLIP
 
-static const uint8_t PROGMEM FONT7_BITMAT[][8] = {
+// Font sources, only read by the compiler: the tables in flash are packed
+// from these by IRM_PackedFont.
+static constexpr uint8_t FONT7_BITMAT[][8] = {
   {4,  B1111,  B1001,  B1001,  B1001,  B1001,  B1111,  B0000}, // ERROR_CHAR
   {1,     B0,     B0,     B0,     B0,     B0,     B0,     B0}, // " "
   {1,     B1,     B1,     B1,     B1,     B0,     B1,     B0}, // !
@@ -135,7 +144,7 @@ static const uint8_t PROGMEM FONT7_BITMAT[][8] = {
   {5, B10001, B10001, B01010, B00100, B00100, B00100, B00000}, // Y
   {4,  B1111,  B0001,  B0010,  B0100,  B1000,  B1111,  B0000}, // Z
   {2,    B11,    B10,    B10,    B10,    B10,    B11,    B00}, // [
-  {5, B00000, B10000, B01000, B00100, B00010, B00001, B00000}, // \ 
+  {5, B00000, B10000, B01000, B00100, B00010, B00001, B00000}, // backslash
   {2,    B11,    B01,    B01,    B01,    B01,    B11,    B00}, // ]
   {3,   B010,   B101,   B000,   B000,   B000,   B000,   B000}, // ^
   {4,  B0000,  B0000,  B0000,  B0000,  B0000,  B1111,  B0000}, // _
@@ -172,7 +181,7 @@ static const uint8_t PROGMEM FONT7_BITMAT[][8] = {
   {5, B00000, B00000, B01000, B10101, B00010, B00000, B00000}, // ~
 };
 
-static const uint8_t PROGMEM FONT5_BITMAT[][6] = {
+static constexpr uint8_t FONT5_BITMAT[][6] = {
   {4,  B1111,  B1001,  B1001,  B1001,  B1111}, // ERROR_CHAR
   {1,     B0,     B0,     B0,     B0,     B0}, // " "
   {1,     B1,     B1,     B1,     B0,     B1}, // !
@@ -234,7 +243,7 @@ static const uint8_t PROGMEM FONT5_BITMAT[][6] = {
   {4,  B1001,  B1001,  B1001,  B0111,  B0001}, // Y
   {4,  B1111,  B0001,  B0110,  B1000,  B1111}, // Z
   {2,    B11,    B10,    B10,    B10,    B11}, // [
-  {4,  B0000,  B1000,  B0100,  B0010,  B0001}, // \ 
+  {4,  B0000,  B1000,  B0100,  B0010,  B0001}, // backslash
   {2,    B11,    B01,    B01,    B01,    B11}, // ]
   {3,   B010,   B101,   B000,   B000,   B000}, // ^
   {3,   B000,   B000,   B000,   B000,   B111}, // _
@@ -271,12 +280,37 @@ static const uint8_t PROGMEM FONT5_BITMAT[][6] = {
   {4,  B0000,  B0101,  B1010,  B0000,  B0000}, // ~
 };
 
+struct Font7 {
+  static constexpr uint8_t rows = 7, bytes = 5;
+  static constexpr uint16_t count = sizeof(FONT7_BITMAT) / 8;
+  static constexpr uint8_t at(uint16_t g, uint8_t i) { return FONT7_BITMAT[g][i]; }
+};
+
+struct Font5 {
+  static constexpr uint8_t rows = 5, bytes = 4;
+  static constexpr uint16_t count = sizeof(FONT5_BITMAT) / 6;
+  static constexpr uint8_t at(uint16_t g, uint8_t i) { return FONT5_BITMAT[g][i]; }
+};
+
+static_assert(Font7::count == 96 && Font5::count == 96,
+              "fonts cover ERROR_CHAR and ' ' to '~'");
+
+#ifdef IRM_GAMMA
+// Pure power curve chosen at build time, e.g. -DIRM_GAMMA=220 for 2.2
+#define IRM_GAMMA5 IRM_Gamma<5, IRM_GAMMA>::table
+#define IRM_GAMMA6 IRM_Gamma<6, IRM_GAMMA>::table
+#else
+#define IRM_GAMMA5 gamma5 // NeoMatrix's tuned tables
+#define IRM_GAMMA6 gamma6
+#endif
+
 // Constructor for single matrix:
 IRM_Mini::IRM_Mini(int w, int h, uint8_t pin,
                                        uint8_t matrixType, neoPixelType ledType)
     : Adafruit_GFX(w, h), Adafruit_NeoPixel(w * h, pin, ledType),
       type(matrixType), matrixWidth(w), matrixHeight(h), tilesX(0), tilesY(0),
-      remapFn(NULL) {}
+      remapFn(NULL), rType(matrixType), rMatrixW(w), rMatrixH(h), rTilesX(0),
+      rTilesY(0) {}
 
 // Constructor for tiled matrices:
 IRM_Mini::IRM_Mini(uint8_t mW, uint8_t mH, uint8_t tX,
@@ -284,15 +318,776 @@ IRM_Mini::IRM_Mini(uint8_t mW, uint8_t mH, uint8_t tX,
                                        uint8_t matrixType, neoPixelType ledType)
     : Adafruit_GFX(mW * tX, mH * tY),
       Adafruit_NeoPixel(mW * mH * tX * tY, pin, ledType), type(matrixType),
-      matrixWidth(mW), matrixHeight(mH), tilesX(tX), tilesY(tY), remapFn(NULL) {
+      matrixWidth(mW), matrixHeight(mH), tilesX(tX), tilesY(tY), remapFn(NULL),
+      rType(matrixType), rMatrixW(mW), rMatrixH(mH), rTilesX(tX), rTilesY(tY) {
+}
+
+IRM_Mini::~IRM_Mini() {
+  if (pipeline)
+    pipeline->end();
+  // Arena memory isn't ours to free; keep ~Adafruit_NeoPixel() off it
+  if (arena && (pixels >= arena) && (pixels < arena + arenaLen))
+    pixels = NULL;
+}
+
+void IRM_Mini::begin(void) {
+  Adafruit_NeoPixel::begin();
+  if (snapMem && restoreSnapshot())
+    show();
+}
+
+bool IRM_Mini::begin(void *buf, size_t size) {
+  arena = (uint8_t *)buf;
+  arenaLen = size;
+  arenaTop = arenaLast = arenaPeak = 0;
+
+  uint8_t *p = (uint8_t *)allocBuffer(numBytes);
+  if (!p) {
+    begin();
+    return false;
+  }
+  memcpy(p, pixels, numBytes);
+  free(pixels); // Last heap release; from here on nothing is malloc'd
+  pixels = p;
+  begin();
+  return true;
+}
+
+void IRM_Mini::show(void) {
+  if (pipeline) {
+    pipeline->publish();
+    return;
+  }
+  if (transOn)
+    markAllDirty(); // Every LED is mid-transition
+  if (!dirtyTiles) {
+    transmit(numLEDs);
+    return;
+  }
+
+  // WS2812 chains can't skip LEDs, but they can stop early: send only up
+  // to the last dirty tile, the rest hold their previous colors.
+  uint16_t n = (dirtyEnd < numLEDs) ? dirtyEnd : numLEDs;
+  if (n && output && !output->partialFrames())
+    n = numLEDs;
+  savedLEDs = numLEDs - n;
+  if (n)
+    transmit(n);
+  memset(dirtyTiles, 0, (numLEDs / dirtyUnit + 8) / 8);
+  dirtyEnd = 0;
+}
+
+// Send the first n LEDs, through the calibration copy if there is one
+void IRM_Mini::transmit(uint16_t n) {
+  if (fb && !pixels) {
+    streamFrame();
+    return;
+  }
+  uint8_t *own = pixels;
+  uint16_t level = 0;
+  if (transOn) {
+    level = stepTransition();
+    pixels = transBuf;
+  }
+  if (fb) { // The LED buffer is only scratch for the encoded frame
+    uint8_t lut[128];
+    encodeLUT(lut);
+    encodeLines(pixels, 0, numLEDs / chainLine(), lut);
+    if (calGains)
+      calibrate(pixels, pixels, n);
+  } else if (calGains && own) {
+    calibrate(calBuf, pixels, n);
+    pixels = calBuf;
+  }
+  if (output) {
+    output->send(pixels, n);
+  } else {
+    uint16_t allBytes = numBytes;
+    numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+    Adafruit_NeoPixel::show();
+    numBytes = allBytes;
+  }
+  pixels = own;
+  if (level == 256)
+    endTransition();
+  if (snapAuto)
+    saveSnapshot();
+}
+
+// Snapshot layout: 'I' 'R' 'S' version | LEDs (2) | bytes per LED |
+// brightness | data length (2) | CRC (2), then the data. The CRC
+// (CRC-16/CCITT-FALSE, as in the stream protocol) covers everything after
+// the magic except itself. Data is ops of a control byte and LEDs: bit 7
+// set means one LED repeated (bits 0-6) + 1 times, clear means that many
+// LEDs follow.
+#define SNAP_HEADER 12
+#define SNAP_VERSION 1
+
+static uint16_t snapCRC(uint16_t crc, const uint8_t *p, size_t n) {
+  while (n--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+void IRM_Mini::setSnapshotMemory(void *mem, size_t size, bool autoSave) {
+  snapMem = (uint8_t *)mem;
+  snapSize = mem ? size : 0;
+  snapAuto = mem && autoSave;
+}
+
+bool IRM_Mini::saveSnapshot(void) {
+  if (!snapMem || (snapSize < SNAP_HEADER) || fb || !pixels)
+    return false;
+  memset(snapMem, 0, 4); // No snapshot until it's complete
+  uint8_t bpp = pixelSize();
+  uint8_t *out = snapMem + SNAP_HEADER, *end = snapMem + snapSize;
+  uint16_t i = 0;
+  while (i < numLEDs) {
+    const uint8_t *p = &pixels[i * bpp];
+    uint16_t n = 1;
+    while ((i + n < numLEDs) && (n < 128) && !memcmp(p, p + n * bpp, bpp))
+      n++;
+    if (n > 1) {
+      if (end - out < 1 + bpp)
+        return false;
+      *out++ = 0x80 | (n - 1);
+      memcpy(out, p, bpp);
+      out += bpp;
+    } else {
+      // Literal LEDs until two in a row match, which start a run
+      while ((i + n < numLEDs) && (n < 128) &&
+             ((i + n + 1 == numLEDs) ||
+              memcmp(p + n * bpp, p + (n + 1) * bpp, bpp)))
+        n++;
+      if (end - out < 1 + n * bpp)
+        return false;
+      *out++ = n - 1;
+      memcpy(out, p, n * bpp);
+      out += n * bpp;
+    }
+    i += n;
+  }
+  uint16_t len = out - (snapMem + SNAP_HEADER);
+  uint8_t *h = snapMem;
+  h[4] = numLEDs;
+  h[5] = numLEDs >> 8;
+  h[6] = bpp;
+  h[7] = brightness;
+  h[8] = len;
+  h[9] = len >> 8;
+  uint16_t crc = snapCRC(0xFFFF, &h[4], 6);
+  crc = snapCRC(crc, snapMem + SNAP_HEADER, len);
+  h[10] = crc;
+  h[11] = crc >> 8;
+  h[3] = SNAP_VERSION;
+  memcpy(h, "IRS", 3);
+  return true;
+}
+
+bool IRM_Mini::restoreSnapshot(void) {
+  snapRestored = false;
+  if (!snapMem || (snapSize < SNAP_HEADER) || fb || !pixels)
+    return false;
+  const uint8_t *h = snapMem;
+  uint8_t bpp = pixelSize();
+  uint16_t len = h[8] | (h[9] << 8);
+  if (memcmp(h, "IRS", 3) || (h[3] != SNAP_VERSION) ||
+      ((h[4] | (h[5] << 8)) != numLEDs) || (h[6] != bpp) ||
+      (len > snapSize - SNAP_HEADER))
+    return false;
+  const uint8_t *in = snapMem + SNAP_HEADER, *end = in + len;
+  uint16_t crc = snapCRC(snapCRC(0xFFFF, &h[4], 6), in, len);
+  if ((h[10] | (h[11] << 8)) != crc)
+    return false;
+
+  uint16_t i = 0;
+  while ((in < end) && (i < numLEDs)) {
+    uint8_t op = *in++;
+    uint16_t n = (op & 0x7F) + 1;
+    size_t need = (op & 0x80) ? bpp : (size_t)n * bpp;
+    if ((n > numLEDs - i) || ((size_t)(end - in) < need))
+      break;
+    if (op & 0x80) {
+      for (uint16_t k = 0; k < n; k++)
+        memcpy(&pixels[(i + k) * bpp], in, bpp);
+    } else {
+      memcpy(&pixels[i * bpp], in, need);
+    }
+    in += need;
+    i += n;
+  }
+  if ((i != numLEDs) || (in != end)) { // Can't happen past the CRC
+    memset(pixels, 0, numBytes);
+    return false;
+  }
+  brightness = h[7]; // The bytes are already scaled by it
+  markAllDirty();
+  snapRestored = true;
+  return true;
+}
+
+// Galois LFSR masks with a period of 2^n - 1, n = 2..16
+static const uint16_t PROGMEM lfsrTaps[] = {
+    0x3,   0x6,   0xC,    0x14,   0x30,   0x60,   0xB8,   0x110,
+    0x240, 0x500, 0xE08, 0x1C80, 0x3802, 0x6000, 0xD008};
+
+bool IRM_Mini::startTransition(uint8_t type, uint16_t ms) {
+  if (fb || pipeline || !pixels)
+    return false;
+  if (!transOn) { // Else carry on from the current mix
+    // Kept between transitions: a later allocation, e.g. by the new
+    // scene, would stop the arena taking it back
+    if (!transBuf && !(transBuf = (uint8_t *)allocBuffer(numBytes)))
+      return false;
+    memcpy(transBuf, pixels, numBytes);
+    transOn = true;
+  }
+  transType = type;
+  transMs = ms ? ms : 1;
+  transLevel = 0;
+  transStart = millis();
+  markAllDirty();
+  return true;
+}
+
+void IRM_Mini::endTransition(void) {
+  transOn = false;
+  markAllDirty();
+}
+
+// Bring transBuf up to date with the live frame for the current time.
+// Returns progress, 0-256.
+uint16_t IRM_Mini::stepTransition(void) {
+  uint32_t elapsed = millis() - transStart;
+  uint16_t level = (elapsed >= transMs) ? 256 : (elapsed << 8) / transMs;
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+
+  switch (transType) {
+  case IRM_FADE:
+    if (level == 256) {
+      memcpy(transBuf, pixels, numBytes);
+    } else if (level > transLevel) {
+      // Cover the same fraction of the remaining distance, so the mix
+      // follows a straight line to a still frame and chases a moving one
+      uint8_t a = ((uint32_t)(level - transLevel) << 8) / (256 - transLevel);
+      uint8_t *m = transBuf;
+      for (uint16_t i = 0; i < numBytes; i++) {
+        uint8_t to = pixels[i];
+        if (to > m[i])
+          m[i] += ((uint16_t)(to - m[i]) * a + 128) >> 8;
+        else
+          m[i] -= ((uint16_t)(m[i] - to) * a + 128) >> 8;
+      }
+    }
+    break;
+  case IRM_WIPE_RIGHT:
+    copyRegion(transBuf, pixels, 0, 0, (_width * level) >> 8, _height);
+    break;
+  case IRM_WIPE_LEFT: {
+    int16_t w = (_width * level) >> 8;
+    copyRegion(transBuf, pixels, _width - w, 0, w, _height);
+    break;
+  }
+  case IRM_WIPE_DOWN:
+    copyRegion(transBuf, pixels, 0, 0, _width, (_height * level) >> 8);
+    break;
+  case IRM_WIPE_UP: {
+    int16_t h = (_height * level) >> 8;
+    copyRegion(transBuf, pixels, 0, _height - h, _width, h);
+    break;
+  }
+  default: { // IRM_DISSOLVE: the first 'count' LEDs of the LFSR order
+    uint16_t count = ((uint32_t)numLEDs * level) >> 8;
+    uint8_t bits = 2;
+    while ((bits < 16) && ((1UL << bits) - 1 < numLEDs))
+      bits++;
+    uint16_t taps = pgm_read_word(&lfsrTaps[bits - 2]);
+    uint16_t state = 1;
+    for (uint16_t done = 0; done < count;) {
+      if (state <= numLEDs) { // Skip states past the chain
+        memcpy(&transBuf[(state - 1) * bpp], &pixels[(state - 1) * bpp], bpp);
+        done++;
+      }
+      state = (state >> 1) ^ ((state & 1) ? taps : 0);
+    }
+  }
+  }
+  transLevel = level;
+  return level;
+}
+
+// Copy a display rectangle between two LED buffers, a chain-contiguous
+// run at a time
+void IRM_Mini::copyRegion(uint8_t *dst, const uint8_t *src, int16_t x,
+                          int16_t y, int16_t w, int16_t h) const {
+  if (!clipRegion(x, y, w, h))
+    return;
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  bool alongX = linesAlongX();
+  int16_t a0 = alongX ? x : y, aLen = alongX ? w : h;
+  int16_t b0 = alongX ? y : x, bLen = alongX ? h : w;
+  for (int16_t b = b0; b < b0 + bLen; b++) {
+    for (int16_t a = a0, n = aLen; n > 0;) {
+      int16_t k = runLength(alongX, a, true);
+      if (k > n)
+        k = n;
+      uint16_t d0 = ledAt(alongX, a, b), d1 = ledAt(alongX, a + k - 1, b);
+      uint16_t first = min(d0, d1);
+      memcpy(&dst[first * bpp], &src[first * bpp], k * bpp);
+      a += k;
+      n -= k;
+    }
+  }
+}
+
+IRM_PixelFormat IRM_Mini::pixelFormat(void) const {
+  IRM_PixelFormat f = {(uint8_t)((wOffset == rOffset) ? 3 : 4), rOffset,
+                       gOffset, bOffset, wOffset};
+  return f;
+}
+
+bool IRM_Mini::setOutput(IRM_Output *out) {
+  if (out) {
+    out->matrix = this; // So begin() can allocate from the arena
+    if (!out->begin(pixelFormat(), numLEDs))
+      return false;
+  }
+  // A framebuffer streaming to the old output may have no LED buffer
+  if (!pixels && !(out && out->chunkedWrites()) &&
+      !(pixels = (uint8_t *)allocBuffer(numBytes)))
+    return false;
+  output = out;
+  markAllDirty(); // The new output hasn't seen any of the frame
+  return true;
+}
+
+void IRM_Output::toRGB(const uint8_t *src, uint8_t *dst, uint16_t count,
+                       bool withW) const {
+  for (uint16_t i = 0; i < count; i++, src += fmt.bpp) {
+    *dst++ = src[fmt.r];
+    *dst++ = src[fmt.g];
+    *dst++ = src[fmt.b];
+    if (withW)
+      *dst++ = (fmt.bpp == 4) ? src[fmt.w] : 0;
+  }
+}
+
+bool IRM_Mini::setCalibration(const uint8_t *gains, uint8_t mode,
+                              bool progmem) {
+  markAllDirty();
+  if (!gains) {
+    calGains = NULL;
+    freeBuffer(calBuf);
+    calBuf = NULL;
+    return true;
+  }
+  // Framebuffer modes calibrate in place as lines stream out; the copy
+  // is made when setFramebuffer() goes back to LED mode
+  if (!fb && !calBuf && !(calBuf = (uint8_t *)allocBuffer(numBytes)))
+    return false;
+  calGains = gains;
+  calMode = mode;
+  calProgmem = progmem;
+  return true;
+}
+
+// Gains are put in wire byte order once per tile, so per-tile mode costs
+// one multiply per channel per LED. src and dst may be the same buffer;
+// they hold n LEDs starting at chain position first.
+void IRM_Mini::calibrate(uint8_t *dst, const uint8_t *src, uint16_t n,
+                         uint16_t first) const {
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint16_t unit = (calMode == IRM_CAL_TILE) ? matrixWidth * matrixHeight : 1;
+  const uint8_t *g = calGains + (first / unit) * 3;
+  uint16_t gain[4] = {256, 256, 256, 256}; // W, if any, is left alone
+  uint32_t last = (uint32_t)first + n;
+
+  for (uint32_t led = first; led < last; g += 3) {
+    gain[rOffset] = (calProgmem ? pgm_read_byte(&g[0]) : g[0]) + 1;
+    gain[gOffset] = (calProgmem ? pgm_read_byte(&g[1]) : g[1]) + 1;
+    gain[bOffset] = (calProgmem ? pgm_read_byte(&g[2]) : g[2]) + 1;
+    uint32_t end = (led / unit + 1) * unit;
+    if (end > last)
+      end = last;
+    if (bpp == 3) {
+      for (; led < end; led++, src += 3, dst += 3) {
+        dst[0] = (src[0] * gain[0]) >> 8;
+        dst[1] = (src[1] * gain[1]) >> 8;
+        dst[2] = (src[2] * gain[2]) >> 8;
+      }
+    } else {
+      for (; led < end; led++, src += 4, dst += 4) {
+        dst[0] = (src[0] * gain[0]) >> 8;
+        dst[1] = (src[1] * gain[1]) >> 8;
+        dst[2] = (src[2] * gain[2]) >> 8;
+        dst[3] = (src[3] * gain[3]) >> 8;
+      }
+    }
+  }
+}
+
+bool IRM_Mini::setPartialShow(bool on) {
+  if (on && fb)
+    return false;
+  if (!on) {
+    freeBuffer(dirtyTiles);
+    dirtyTiles = NULL;
+    savedLEDs = 0;
+    return true;
+  }
+  if (dirtyTiles)
+    return true;
+
+  if (tilesX) {
+    dirtyUnit = matrixWidth * matrixHeight;
+  } else { // Single matrix: one line along the major axis per 'tile'
+    dirtyUnit = ((type & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS) ? matrixWidth
+                                                              : matrixHeight;
+  }
+  size_t mapBytes = (numLEDs / dirtyUnit + 8) / 8;
+  if (!(dirtyTiles = (uint8_t *)allocBuffer(mapBytes)))
+    return false;
+  memset(dirtyTiles, 0, mapBytes);
+  markAllDirty(); // Chain state unknown until the first full show()
+  return true;
+}
+
+void IRM_Mini::markAllDirty(void) {
+  if (dirtyTiles) {
+    memset(dirtyTiles, 0xFF, (numLEDs / dirtyUnit + 8) / 8);
+    dirtyEnd = numLEDs;
+  }
+}
+
+bool IRM_Mini::isTileDirty(uint16_t tile) const {
+  if (!dirtyTiles)
+    return true;
+  if (tile >= (numLEDs + dirtyUnit - 1) / dirtyUnit)
+    return false;
+  return dirtyTiles[tile >> 3] & (1 << (tile & 7));
+}
+
+void IRM_Mini::setBrightness(uint8_t b) {
+  if (fb) { // Applied as frames are encoded; nothing to rescale
+    brightness = b + 1;
+    return;
+  }
+  Adafruit_NeoPixel::setBrightness(b);
+  markAllDirty();
+}
+
+void IRM_Mini::clear(void) {
+  if (fb) {
+    memset(fb, 0, (size_t)numLEDs * pixelSize());
+    return;
+  }
+  Adafruit_NeoPixel::clear();
+  markAllDirty();
+}
+
+bool IRM_Mini::setFramebuffer(uint8_t mode) {
+  if (mode == fbMode)
+    return true;
+  endTransition();
+  freeBuffer(transBuf); // Transitions are LED mode only
+  transBuf = NULL;
+  if (mode == IRM_FB_LED) {
+    if (!pixels && !(pixels = (uint8_t *)allocBuffer(numBytes)))
+      return false;
+    if (calGains && !calBuf && !(calBuf = (uint8_t *)allocBuffer(numBytes)))
+      return false;
+    uint8_t lut[128]; // Keep the picture
+    encodeLUT(lut);
+    encodeLines(pixels, 0, numLEDs / chainLine(), lut);
+    freeBuffer(palette);
+    palette = NULL;
+    freeBuffer(fb);
+    fb = NULL;
+    fbMode = IRM_FB_LED;
+    markAllDirty();
+    return true;
+  }
+  if (((mode != IRM_FB_RGB565) && (mode != IRM_FB_PAL8)) || remapFn ||
+      pipeline)
+    return false;
+  if (fb && !setFramebuffer(IRM_FB_LED))
+    return false;
+
+  if (!lineBuf &&
+      !(lineBuf = (uint8_t *)allocBuffer(max(WIDTH, HEIGHT) * 4)))
+    return false;
+  if (!(fb = (uint8_t *)allocBuffer((size_t)numLEDs * (mode / 8))))
+    return false;
+  if (mode == IRM_FB_PAL8) {
+    if (!(palette = (uint8_t *)allocBuffer(256 * 3))) {
+      freeBuffer(fb);
+      fb = NULL;
+      return false;
+    }
+    for (uint16_t i = 0; i < 256 * 3; i++)
+      palette[i] = i / 3;
+  }
+  fbMode = mode;
+  memset(fb, 0, (size_t)numLEDs * pixelSize());
+  setPartialShow(false);
+  if (calBuf) { // Frames are calibrated in place from now on
+    freeBuffer(calBuf);
+    calBuf = NULL;
+  }
+  // Streaming line by line needs no LED buffer; arena memory stays put
+  if (output && output->chunkedWrites() && !arena) {
+    free(pixels);
+    pixels = NULL;
+  }
+  return true;
+}
+
+// Bytes per pixel of whatever drawing writes to
+uint8_t IRM_Mini::pixelSize(void) const {
+  return fb ? fbMode / 8 : ((wOffset == rOffset) ? 3 : 4);
+}
+
+// LEDs per line along the matrix's major axis, the unit show() encodes
+uint16_t IRM_Mini::chainLine(void) const {
+  return ((rType & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS) ? rMatrixW : rMatrixH;
+}
+
+// Inverse of mapXY() for the standard layouts: display position of a LED
+void IRM_Mini::ledXY(uint16_t led, int16_t &x, int16_t &y) const {
+  uint16_t perTile = rMatrixW * rMatrixH;
+  uint16_t major, minor, majorScale;
+  uint8_t corner = rType & NEO_MATRIX_CORNER;
+  int16_t tileX = 0, tileY = 0;
+
+  if (rTilesX) {
+    uint16_t tile = led / perTile;
+    led -= tile * perTile;
+    majorScale = ((rType & NEO_TILE_AXIS) == NEO_TILE_ROWS) ? rTilesX
+                                                             : rTilesY;
+    major = tile / majorScale;
+    minor = tile - major * majorScale;
+    if (((rType & NEO_TILE_SEQUENCE) != NEO_TILE_PROGRESSIVE) &&
+        (major & 1)) {
+      #ifndef NEO_TILE_ZIGZAG_NOFLIP
+      corner ^= NEO_MATRIX_CORNER;
+      #endif
+      minor = majorScale - 1 - minor;
+    }
+    if ((rType & NEO_TILE_AXIS) != NEO_TILE_ROWS)
+      _swap_uint16_t(major, minor);
+    if (rType & NEO_TILE_RIGHT)
+      minor = rTilesX - 1 - minor;
+    if (rType & NEO_TILE_BOTTOM)
+      major = rTilesY - 1 - major;
+    tileX = minor * rMatrixW;
+    tileY = major * rMatrixH;
+  }
+
+  majorScale = chainLine();
+  major = led / majorScale;
+  minor = led - major * majorScale;
+  if (((rType & NEO_MATRIX_SEQUENCE) != NEO_MATRIX_PROGRESSIVE) && (major & 1))
+    minor = majorScale - 1 - minor;
+  if ((rType & NEO_MATRIX_AXIS) != NEO_MATRIX_ROWS)
+    _swap_uint16_t(major, minor);
+  if (corner & NEO_MATRIX_RIGHT)
+    minor = rMatrixW - 1 - minor;
+  if (corner & NEO_MATRIX_BOTTOM)
+    major = rMatrixH - 1 - major;
+  x = tileX + minor;
+  y = tileY + major;
+}
+
+// Gamma and brightness folded into one RAM table per frame: 32 red/blue
+// entries, then 64 green
+void IRM_Mini::encodeLUT(uint8_t *lut) const {
+  if (fbMode != IRM_FB_RGB565)
+    return;
+  for (uint8_t i = 0; i < 96; i++) {
+    uint8_t v = (i < 32) ? pgm_read_byte(&IRM_GAMMA5[i])
+                         : pgm_read_byte(&IRM_GAMMA6[i - 32]);
+    lut[i] = brightness ? (v * brightness) >> 8 : v;
+  }
+}
+
+// Encode chain lines [first, first + count) into LED bytes. Each line is
+// straight in display space, so only its two ends are mapped and the
+// framebuffer is walked with a fixed stride in between. Palette colors
+// are scaled as they're copied (256 = full brightness).
+void IRM_Mini::encodeLines(uint8_t *dst, uint16_t first, uint16_t count,
+                           const uint8_t *lut) const {
+  const uint16_t *src = (const uint16_t *)fb;
+  uint16_t len = chainLine();
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t r = rOffset, g = gOffset, b = bOffset;
+  uint16_t scale = brightness ? brightness : 256;
+
+  for (uint16_t line = first; line < first + count; line++) {
+    int16_t x0, y0, x1, y1;
+    ledXY(line * len, x0, y0);
+    ledXY(line * len + len - 1, x1, y1);
+    int32_t i = (int32_t)y0 * _width + x0;
+    int32_t step = (len > 1) ? ((x1 - x0) + (int32_t)(y1 - y0) * _width) /
+                                   (len - 1)
+                             : 0;
+    if (fbMode == IRM_FB_PAL8) {
+      for (uint16_t n = 0; n < len; n++, i += step, dst += bpp) {
+        const uint8_t *c = &palette[fb[i] * 3];
+        dst[r] = (c[0] * scale) >> 8;
+        dst[g] = (c[1] * scale) >> 8;
+        dst[b] = (c[2] * scale) >> 8;
+        if (bpp == 4)
+          dst[wOffset] = 0;
+      }
+      continue;
+    }
+    for (uint16_t n = 0; n < len; n++, i += step, dst += bpp) {
+      uint16_t c = src[i];
+      dst[r] = lut[c >> 11];
+      dst[g] = lut[32 + ((c >> 5) & 0x3F)];
+      dst[b] = lut[c & 0x1F];
+      if (bpp == 4)
+        dst[wOffset] = 0;
+    }
+  }
+}
+
+// Framebuffer to output a line at a time, through lineBuf
+void IRM_Mini::streamFrame(void) {
+  uint8_t lut[128];
+  encodeLUT(lut);
+  uint16_t len = chainLine();
+  output->beginFrame(numLEDs);
+  for (uint16_t led = 0; led < numLEDs; led += len) {
+    encodeLines(lineBuf, led / len, 1, lut);
+    if (calGains)
+      calibrate(lineBuf, lineBuf, len, led);
+    output->write(lineBuf, len);
+  }
+  output->endFrame();
+}
+
+void *IRM_Mini::allocBuffer(size_t bytes) {
+  if (!arena)
+    return malloc(bytes);
+
+  // Round start up to 4 bytes so 16/32-bit buffers can live here too
+  size_t start = (arenaTop + 3) & ~(size_t)3;
+  if ((start > arenaLen) || (bytes > arenaLen - start))
+    return NULL;
+  arenaLast = start;
+  arenaTop = start + bytes;
+  if (arenaTop > arenaPeak)
+    arenaPeak = arenaTop;
+  return arena + start;
+}
+
+void IRM_Mini::freeBuffer(void *buf) {
+  if (!buf)
+    return;
+  if (!arena) {
+    free(buf);
+    return;
+  }
+  // Bump allocator: only the newest block can be handed back
+  if ((uint8_t *)buf == arena + arenaLast) {
+    arenaTop = arenaLast;
+  }
 }
 
 // Expand 16-bit input color (Adafruit_GFX colorspace) to 24-bit (NeoPixel)
 // (w/gamma adjustment)
 static uint32_t expandColor(uint16_t color) {
-  return ((uint32_t)pgm_read_byte(&gamma5[color >> 11]) << 16) |
-         ((uint32_t)pgm_read_byte(&gamma6[(color >> 5) & 0x3F]) << 8) |
-         pgm_read_byte(&gamma5[color & 0x1F]);
+  return ((uint32_t)pgm_read_byte(&IRM_GAMMA5[color >> 11]) << 16) |
+         ((uint32_t)pgm_read_byte(&IRM_GAMMA6[(color >> 5) & 0x3F]) << 8) |
+         pgm_read_byte(&IRM_GAMMA5[color & 0x1F]);
+}
+
+// A drawing color as stored by fillLEDs(): raw in a framebuffer, else
+// 24/32-bit for the LED buffer
+uint32_t IRM_Mini::spanColor(uint16_t color) const {
+  if (fb)
+    return color;
+  return passThruFlag ? passThruColor : expandColor(color);
+}
+
+void IRM_Mini::setPalette(const uint8_t *rgb, uint8_t first, uint16_t count,
+                          bool progmem) {
+  if (!palette)
+    return;
+  if (count > 256 - first)
+    count = 256 - first;
+  uint8_t *p = &palette[first * 3];
+  for (uint16_t i = 0; i < count * 3; i++)
+    p[i] = progmem ? pgm_read_byte(&rgb[i]) : rgb[i];
+}
+
+void IRM_Mini::setPaletteColor(uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+  if (palette) {
+    palette[i * 3] = r;
+    palette[i * 3 + 1] = g;
+    palette[i * 3 + 2] = b;
+  }
+}
+
+void IRM_Mini::setPaletteColor(uint8_t i, uint16_t color) {
+  uint32_t c = expandColor(color);
+  setPaletteColor(i, c >> 16, c >> 8, c);
+}
+
+uint32_t IRM_Mini::getPaletteColor(uint8_t i) const {
+  if (!palette)
+    return 0;
+  const uint8_t *p = &palette[i * 3];
+  return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+// Reverse entries [a, b] in place
+static void reverseEntries(uint8_t *pal, uint16_t a, uint16_t b) {
+  for (; a < b; a++, b--) {
+    for (uint8_t k = 0; k < 3; k++) {
+      uint8_t t = pal[a * 3 + k];
+      pal[a * 3 + k] = pal[b * 3 + k];
+      pal[b * 3 + k] = t;
+    }
+  }
+}
+
+// Three reversals rotate the range in place, with no scratch buffer
+void IRM_Mini::rotatePalette(int16_t steps, uint8_t first, uint8_t last) {
+  if (!palette || (last <= first))
+    return;
+  int16_t len = last - first + 1;
+  steps %= len;
+  if (steps < 0)
+    steps += len;
+  if (!steps)
+    return;
+  reverseEntries(palette, first, last);
+  reverseEntries(palette, first, first + steps - 1);
+  reverseEntries(palette, first + steps, last);
+}
+
+void IRM_Mini::fadePalette(const uint8_t *target, uint8_t amount,
+                           uint8_t first, uint16_t count, bool progmem) {
+  if (!palette)
+    return;
+  if (count > 256 - first)
+    count = 256 - first;
+  uint8_t *p = &palette[first * 3];
+  for (uint16_t i = 0; i < count * 3; i++) {
+    uint8_t t = !target ? 0 : progmem ? pgm_read_byte(&target[i]) : target[i];
+    int16_t d = t - p[i];
+    if (!d)
+      continue;
+    int16_t step = (d * (amount + 1)) / 256;
+    if (!step)
+      step = (d > 0) ? 1 : -1;
+    p[i] += step;
+  }
 }
 
 uint16_t IRM_Mini::Color(uint8_t r, uint8_t g, uint8_t b) {
@@ -308,62 +1103,96 @@ void IRM_Mini::setPassThruColor(uint32_t c) {
 // Call without a value to reset (disable passthrough)
 void IRM_Mini::setPassThruColor(void) { passThruFlag = false; }
 
-void IRM_Mini::drawPixel(int16_t x, int16_t y, uint16_t color) {
+// Rotate a set of NEO_MATRIX_* or NEO_TILE_* corner/axis bits 90 degrees
+// clockwise, matching Adafruit_GFX rotation 1 (x' = WIDTH - 1 - y, y' = x):
+// the axis flips, the new right edge is the old bottom and the new bottom
+// is the old left.
+static uint8_t rotateLayout(uint8_t t, uint8_t right, uint8_t bottom,
+                            uint8_t axis) {
+  uint8_t r = t & ~(right | bottom);
+  if (t & bottom)
+    r |= right;
+  if (!(t & right))
+    r |= bottom;
+  return r ^ axis;
+}
 
-  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
-    return;
+void IRM_Mini::setRotation(uint8_t r) {
+  Adafruit_GFX::setRotation(r);
 
-  int16_t t;
-  switch (rotation) {
-  case 1:
-    t = x;
-    x = WIDTH - 1 - y;
-    y = t;
-    break;
-  case 2:
-    x = WIDTH - 1 - x;
-    y = HEIGHT - 1 - y;
-    break;
-  case 3:
-    t = x;
-    x = y;
-    y = HEIGHT - 1 - t;
-    break;
+  // Fold the rotation into the layout so mapXY() costs the same for
+  // every rotation: rotating a matrix is the same as a rotated layout
+  // with width and height swapped.
+  rType = type;
+  rMatrixW = matrixWidth;
+  rMatrixH = matrixHeight;
+  rTilesX = tilesX;
+  rTilesY = tilesY;
+  for (uint8_t i = 0; i < rotation; i++) {
+    rType = rotateLayout(rType, NEO_MATRIX_RIGHT, NEO_MATRIX_BOTTOM,
+                         NEO_MATRIX_AXIS);
+    rType = rotateLayout(rType, NEO_TILE_RIGHT, NEO_TILE_BOTTOM,
+                         NEO_TILE_AXIS);
+    uint8_t t = rMatrixW;
+    rMatrixW = rMatrixH;
+    rMatrixH = t;
+    t = rTilesX;
+    rTilesX = rTilesY;
+    rTilesY = t;
   }
+}
 
+uint16_t IRM_Mini::mapXY(int16_t x, int16_t y) const {
   int tileOffset = 0, pixelOffset;
 
-  if (remapFn) { // Custom X/Y remapping function
+  if (remapFn) { // Custom X/Y remapping function, unrotated coordinates
+    int16_t t;
+    switch (rotation) {
+    case 1:
+      t = x;
+      x = WIDTH - 1 - y;
+      y = t;
+      break;
+    case 2:
+      x = WIDTH - 1 - x;
+      y = HEIGHT - 1 - y;
+      break;
+    case 3:
+      t = x;
+      x = y;
+      y = HEIGHT - 1 - t;
+      break;
+    }
     pixelOffset = (*remapFn)(x, y);
-  } else { // Standard single matrix or tiled matrices
+  } else { // Standard single matrix or tiled matrices, rotation folded in
 
-    uint8_t corner = type & NEO_MATRIX_CORNER;
+    uint8_t corner = rType & NEO_MATRIX_CORNER;
     uint16_t minor, major, majorScale;
 
-    if (tilesX) { // Tiled display, multiple matrices
+    if (rTilesX) { // Tiled display, multiple matrices
       uint16_t tile;
 
-      minor = x / matrixWidth;           // Tile # X/Y; presume row major to
-      major = y / matrixHeight,          // start (will swap later if needed)
-          x = x - (minor * matrixWidth); // Pixel X/Y within tile
-      y = y - (major * matrixHeight);    // (-* is less math than modulo)
+      minor = x / rMatrixW;           // Tile # X/Y; presume row major to
+      major = y / rMatrixH,           // start (will swap later if needed)
+          x = x - (minor * rMatrixW); // Pixel X/Y within tile
+      y = y - (major * rMatrixH);     // (-* is less math than modulo)
 
       // Determine corner of entry, flip axes if needed
-      if (type & NEO_TILE_RIGHT)
-        minor = tilesX - 1 - minor;
-      if (type & NEO_TILE_BOTTOM)
-        major = tilesY - 1 - major;
+      if (rType & NEO_TILE_RIGHT)
+        minor = rTilesX - 1 - minor;
+      if (rType & NEO_TILE_BOTTOM)
+        major = rTilesY - 1 - major;
 
       // Determine actual major axis of tiling
-      if ((type & NEO_TILE_AXIS) == NEO_TILE_ROWS) {
-        majorScale = tilesX;
+      if ((rType & NEO_TILE_AXIS) == NEO_TILE_ROWS) {
+        majorScale = rTilesX;
       } else {
         _swap_uint16_t(major, minor);
-        majorScale = tilesY;
+        majorScale = rTilesY;
       }
 
       // Determine tile number
-      if ((type & NEO_TILE_SEQUENCE) == NEO_TILE_PROGRESSIVE) {
+      if ((rType & NEO_TILE_SEQUENCE) == NEO_TILE_PROGRESSIVE) {
         // All tiles in same order
         tile = major * majorScale + minor;
       } else {
@@ -382,7 +1211,7 @@ void IRM_Mini::drawPixel(int16_t x, int16_t y, uint16_t color) {
       }
 
       // Index of first pixel in tile
-      tileOffset = tile * matrixWidth * matrixHeight;
+      tileOffset = tile * rMatrixW * rMatrixH;
 
     } // else no tiling (handle as single tile)
 
@@ -392,20 +1221,20 @@ void IRM_Mini::drawPixel(int16_t x, int16_t y, uint16_t color) {
 
     // Determine corner of entry, flip axes if needed
     if (corner & NEO_MATRIX_RIGHT)
-      minor = matrixWidth - 1 - minor;
+      minor = rMatrixW - 1 - minor;
     if (corner & NEO_MATRIX_BOTTOM)
-      major = matrixHeight - 1 - major;
+      major = rMatrixH - 1 - major;
 
     // Determine actual major axis of matrix
-    if ((type & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS) {
-      majorScale = matrixWidth;
+    if ((rType & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS) {
+      majorScale = rMatrixW;
     } else {
       _swap_uint16_t(major, minor);
-      majorScale = matrixHeight;
+      majorScale = rMatrixH;
     }
 
     // Determine pixel number within tile/matrix
-    if ((type & NEO_MATRIX_SEQUENCE) == NEO_MATRIX_PROGRESSIVE) {
+    if ((rType & NEO_MATRIX_SEQUENCE) == NEO_MATRIX_PROGRESSIVE) {
       // All lines in same order
       pixelOffset = major * majorScale + minor;
     } else {
@@ -417,61 +1246,623 @@ void IRM_Mini::drawPixel(int16_t x, int16_t y, uint16_t color) {
     }
   }
 
-  setPixelColor(tileOffset + pixelOffset,
-                passThruFlag ? passThruColor : expandColor(color));
+  return tileOffset + pixelOffset;
+}
+
+void IRM_Mini::drawPixel(int16_t x, int16_t y, uint16_t color) {
+
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return;
+
+  if (fb) {
+    if (fbMode == IRM_FB_PAL8)
+      fb[y * _width + x] = color;
+    else
+      ((uint16_t *)fb)[y * _width + x] = color;
+    return;
+  }
+  uint16_t i = mapXY(x, y);
+  markDirty(i);
+  setPixelColor(i, passThruFlag ? passThruColor : expandColor(color));
 }
 
 void IRM_Mini::fillScreen(uint16_t color) {
-  uint16_t i, n;
-  uint32_t c;
+  fillLEDs(0, numLEDs, spanColor(color));
+  markAllDirty();
+}
+
+void IRM_Mini::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint16_t color) {
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  if (!clipRegion(x, y, w, h))
+    return;
+
+  uint32_t c = spanColor(color);
+  if (linesAlongX()) {
+    for (int16_t j = y; j < y + h; j++)
+      fillSpan(true, x, j, w, c);
+  } else {
+    for (int16_t i = x; i < x + w; i++)
+      fillSpan(false, y, i, h, c);
+  }
+}
+
+void IRM_Mini::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void IRM_Mini::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+// Along a run the LED index steps by one (backwards on reversed zigzag
+// lines), so the wire bytes are stored directly, as setPixelColor() would.
+void IRM_Mini::drawRow(int16_t x, int16_t y, const uint16_t *colors,
+                       int16_t w) {
+  if ((y < 0) || (y >= _height))
+    return;
+  if (x < 0) {
+    colors -= x;
+    w += x;
+    x = 0;
+  }
+  if (w > _width - x)
+    w = _width - x;
+  if (w <= 0)
+    return;
+
+  if (fb) {
+    if (fbMode == IRM_FB_PAL8) {
+      uint8_t *dst = &fb[y * _width + x];
+      for (int16_t i = 0; i < w; i++)
+        dst[i] = colors[i];
+    } else {
+      memcpy(&((uint16_t *)fb)[y * _width + x], colors, w * 2);
+    }
+    return;
+  }
+  if (!pixels)
+    return;
+  uint8_t bpp = pixelSize();
+  bool alongX = linesAlongX();
+  while (w > 0) {
+    int16_t k = alongX ? runLength(true, x, true) : 1;
+    if (k > w)
+      k = w;
+    uint16_t d0 = mapXY(x, y), d1 = (k > 1) ? mapXY(x + k - 1, y) : d0;
+    int16_t step = (d1 >= d0) ? bpp : -bpp;
+    uint8_t *p = &pixels[d0 * bpp];
+    for (int16_t i = 0; i < k; i++, p += step) {
+      uint32_t c = passThruFlag ? passThruColor : expandColor(*colors++);
+      uint8_t r = c >> 16, g = c >> 8, b = c, wh = c >> 24;
+      if (brightness) {
+        r = (r * brightness) >> 8;
+        g = (g * brightness) >> 8;
+        b = (b * brightness) >> 8;
+        wh = (wh * brightness) >> 8;
+      }
+      p[rOffset] = r;
+      p[gOffset] = g;
+      p[bOffset] = b;
+      if (bpp == 4)
+        p[wOffset] = wh;
+    }
+    markDirty(d0);
+    markDirty(d1);
+    x += k;
+    w -= k;
+  }
+}
+
+void IRM_Mini::drawPixels(const int16_t *xs, const int16_t *ys,
+                          const uint16_t *colors, uint16_t n) {
+  plotPixels(xs, ys, colors, 0, n);
+}
+
+void IRM_Mini::drawPixels(const int16_t *xs, const int16_t *ys, uint16_t n,
+                          uint16_t color) {
+  plotPixels(xs, ys, NULL, color, n);
+}
+
+// Shared by both drawPixels(): per-pixel colors, or one color if colors is
+// NULL
+void IRM_Mini::plotPixels(const int16_t *xs, const int16_t *ys,
+                          const uint16_t *colors, uint16_t color,
+                          uint16_t n) {
+  if (fb) {
+    for (uint16_t i = 0; i < n; i++) {
+      int16_t x = xs[i], y = ys[i];
+      if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+        continue;
+      uint16_t c = colors ? colors[i] : color;
+      if (fbMode == IRM_FB_PAL8)
+        fb[y * _width + x] = c;
+      else
+        ((uint16_t *)fb)[y * _width + x] = c;
+    }
+    return;
+  }
+  if (!pixels)
+    return;
+
+  uint8_t bpp = pixelSize();
+  uint8_t wire[4]; // R, G, B, W with brightness, for the current color
+  uint16_t last = 0;
+  bool have = false; // wire holds last
+
+  // mapXY()'s math with the layout decided up front; only a remap
+  // function still goes through mapXY()
+  bool direct = !remapFn;
+  bool columns = (rType & NEO_MATRIX_AXIS) != NEO_MATRIX_ROWS;
+  bool zigzag = (rType & NEO_MATRIX_SEQUENCE) != NEO_MATRIX_PROGRESSIVE;
+  uint16_t scale = columns ? rMatrixH : rMatrixW;
+  bool tileRight = rType & NEO_TILE_RIGHT, tileBottom = rType & NEO_TILE_BOTTOM;
+  bool tileColumns = (rType & NEO_TILE_AXIS) != NEO_TILE_ROWS;
+  bool tileZigzag = (rType & NEO_TILE_SEQUENCE) != NEO_TILE_PROGRESSIVE;
+  uint16_t tileScale = tileColumns ? rTilesY : rTilesX;
+  uint16_t tileSize = rMatrixW * rMatrixH;
+
+  for (uint16_t i = 0; i < n; i++) {
+    int16_t x = xs[i], y = ys[i];
+    if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+      continue;
+    uint16_t led;
+    if (direct) {
+      uint16_t minor = x, major = y, tile = 0;
+      uint8_t corner = rType & NEO_MATRIX_CORNER;
+      if (rTilesX) {
+        uint16_t tx = minor / rMatrixW, ty = major / rMatrixH;
+        minor -= tx * rMatrixW;
+        major -= ty * rMatrixH;
+        if (tileRight)
+          tx = rTilesX - 1 - tx;
+        if (tileBottom)
+          ty = rTilesY - 1 - ty;
+        if (tileColumns)
+          _swap_uint16_t(tx, ty);
+        if (tileZigzag && (ty & 1)) {
+          #ifndef NEO_TILE_ZIGZAG_NOFLIP
+          corner ^= NEO_MATRIX_CORNER;
+          #endif
+          tx = tileScale - 1 - tx;
+        }
+        tile = ty * tileScale + tx;
+      }
+      if (corner & NEO_MATRIX_RIGHT)
+        minor = rMatrixW - 1 - minor;
+      if (corner & NEO_MATRIX_BOTTOM)
+        major = rMatrixH - 1 - major;
+      if (columns)
+        _swap_uint16_t(major, minor);
+      if (zigzag && (major & 1))
+        minor = scale - 1 - minor;
+      led = tile * tileSize + major * scale + minor;
+    } else {
+      led = mapXY(x, y);
+    }
+
+    uint16_t c = colors ? colors[i] : color;
+    if (!have || (c != last)) {
+      uint32_t v = passThruFlag ? passThruColor : expandColor(c);
+      wire[0] = v >> 16;
+      wire[1] = v >> 8;
+      wire[2] = v;
+      wire[3] = v >> 24;
+      if (brightness)
+        for (uint8_t j = 0; j < 4; j++)
+          wire[j] = (wire[j] * brightness) >> 8;
+      last = c;
+      have = true;
+    }
+    uint8_t *p = &pixels[led * bpp];
+    p[rOffset] = wire[0];
+    p[gOffset] = wire[1];
+    p[bOffset] = wire[2];
+    if (bpp == 4)
+      p[wOffset] = wire[3];
+    markDirty(led);
+  }
+}
+
+// Set n consecutive LEDs (or framebuffer pixels) to one color. The wire
+// bytes (order, brightness) are worked out once like setPixelColor() would,
+// then doubled up with memcpy, or a single memset when all bytes match
+// (black, white, greys).
+void IRM_Mini::fillLEDs(uint16_t led, uint16_t n, uint32_t c) {
+  uint8_t *buf = fb ? fb : pixels;
+  if (!buf || !n)
+    return;
+  uint8_t bpp = pixelSize();
+  uint8_t *p = &buf[led * bpp];
+  size_t total = (size_t)n * bpp;
+  if (fbMode == IRM_FB_PAL8) {
+    p[0] = c;
+  } else if (fb) {
+    uint16_t v = c;
+    memcpy(p, &v, 2);
+  } else {
+    uint8_t r = c >> 16, g = c >> 8, b = c, w = c >> 24;
+    if (brightness) {
+      r = (r * brightness) >> 8;
+      g = (g * brightness) >> 8;
+      b = (b * brightness) >> 8;
+      w = (w * brightness) >> 8;
+    }
+    p[rOffset] = r;
+    p[gOffset] = g;
+    p[bOffset] = b;
+    if (bpp == 4)
+      p[wOffset] = w;
+  }
+  if (!memcmp(p, p + 1, bpp - 1)) {
+    memset(p, p[0], total);
+    return;
+  }
+  for (size_t done = bpp; done < total;) {
+    size_t k = (done < total - done) ? done : total - done;
+    memcpy(p + done, p, k);
+    done += k;
+  }
+}
+
+// Scrolling works on 'lines' along whichever axis is contiguous in the
+// chain (rows for NEO_MATRIX_ROWS layouts, else columns), so the pixel data
+// can be moved in runs with memmove() instead of pixel by pixel.
+// A framebuffer is row-major, so its rows are whole runs.
+bool IRM_Mini::linesAlongX(void) const {
+  return fb || remapFn || ((rType & NEO_MATRIX_AXIS) == NEO_MATRIX_ROWS);
+}
+
+// LED (or framebuffer pixel) index at position a along line b
+uint16_t IRM_Mini::ledAt(bool alongX, int16_t a, int16_t b) const {
+  if (fb)
+    return alongX ? b * _width + a : a * _width + b;
+  return alongX ? mapXY(a, b) : mapXY(b, a);
+}
+
+// How many LEDs from line position a (heading forward or backward) are
+// consecutive in the chain, i.e. stay within one line of one tile.
+uint16_t IRM_Mini::runLength(bool alongX, int16_t a, bool forward) const {
+  if (fb)
+    return forward ? (alongX ? _width : _height) - a : a + 1;
+  if (remapFn)
+    return 1;
+  uint8_t len = alongX ? rMatrixW : rMatrixH;
+  uint8_t pos = a % len;
+  return forward ? len - pos : pos + 1;
+}
+
+// Copy n pixels between two spans of the LED buffer. Within one line the
+// copy walks away from the overlap; across lines the spans are disjoint.
+void IRM_Mini::moveSpan(bool alongX, int16_t dstA, int16_t dstB,
+                        int16_t srcA, int16_t srcB, int16_t n) {
+  uint8_t *buf = fb ? fb : pixels;
+  uint8_t bpp = pixelSize();
+  bool forward = (dstB != srcB) || (dstA <= srcA);
+
+  while (n > 0) {
+    int16_t d = forward ? dstA : dstA + n - 1;
+    int16_t s = forward ? srcA : srcA + n - 1;
+    int16_t k = min(runLength(alongX, d, forward), runLength(alongX, s, forward));
+    if (k > n)
+      k = n;
+    if (!forward) {
+      d -= k - 1;
+      s -= k - 1;
+    }
+    uint16_t d0 = ledAt(alongX, d, dstB), d1 = ledAt(alongX, d + k - 1, dstB);
+    uint16_t s0 = ledAt(alongX, s, srcB), s1 = ledAt(alongX, s + k - 1, srcB);
+    if ((d1 >= d0) == (s1 >= s0)) {
+      // Both runs head the same way along the chain: a single block move
+      memmove(&buf[min(d0, d1) * bpp], &buf[min(s0, s1) * bpp],
+              k * bpp);
+    } else {
+      // Zigzag lines run opposite ways; reverse while copying
+      uint8_t *dp = &buf[min(d0, d1) * bpp];
+      uint8_t *sp = &buf[max(s0, s1) * bpp];
+      for (int16_t i = 0; i < k; i++, dp += bpp, sp -= bpp)
+        memcpy(dp, sp, bpp);
+    }
+    markDirty(d0);
+    markDirty(d1);
+    n -= k;
+    if (forward) {
+      dstA += k;
+      srcA += k;
+    }
+  }
+}
+
+// Fill n pixels of a line, a chain-contiguous run at a time
+void IRM_Mini::fillSpan(bool alongX, int16_t a, int16_t b, int16_t n,
+                        uint32_t c) {
+  while (n > 0) {
+    int16_t k = runLength(alongX, a, true);
+    if (k > n)
+      k = n;
+    uint16_t d0 = ledAt(alongX, a, b), d1 = ledAt(alongX, a + k - 1, b);
+    fillLEDs(min(d0, d1), k, c);
+    markDirty(d0);
+    markDirty(d1);
+    a += k;
+    n -= k;
+  }
+}
+
+// Save a span to lineBuf (save = true) or restore it from there
+void IRM_Mini::copySpan(bool alongX, int16_t a, int16_t b, int16_t n,
+                        bool save) {
+  uint8_t *buf = fb ? fb : pixels;
+  uint8_t bpp = pixelSize();
+  for (int16_t i = 0; i < n; i++) {
+    uint16_t led = ledAt(alongX, a + i, b);
+    if (save) {
+      memcpy(&lineBuf[i * bpp], &buf[led * bpp], bpp);
+    } else {
+      memcpy(&buf[led * bpp], &lineBuf[i * bpp], bpp);
+      markDirty(led);
+    }
+  }
+}
+
+bool IRM_Mini::clipRegion(int16_t &x, int16_t &y, int16_t &w,
+                          int16_t &h) const {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width)
+    w = _width - x;
+  if (y + h > _height)
+    h = _height - y;
+  return (w > 0) && (h > 0);
+}
+
+void IRM_Mini::scroll(int16_t dx, int16_t dy, uint16_t fillColor) {
+  scroll(0, 0, _width, _height, dx, dy, fillColor);
+}
+
+void IRM_Mini::scroll(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx,
+                      int16_t dy, uint16_t fillColor) {
+  if (!clipRegion(x, y, w, h))
+    return;
+
+  bool alongX = linesAlongX();
+  int16_t a0 = alongX ? x : y, aLen = alongX ? w : h, da = alongX ? dx : dy;
+  int16_t b0 = alongX ? y : x, bLen = alongX ? h : w, db = alongX ? dy : dx;
+  uint32_t c = spanColor(fillColor);
+
+  for (int16_t i = 0; i < bLen; i++) {
+    // Walk lines away from the direction of travel so sources are intact
+    int16_t b = (db > 0) ? b0 + bLen - 1 - i : b0 + i;
+    int16_t sb = b - db;
+    if ((sb < b0) || (sb >= b0 + bLen) || (abs(da) >= aLen)) {
+      fillSpan(alongX, a0, b, aLen, c);
+    } else if (da >= 0) {
+      moveSpan(alongX, a0 + da, b, a0, sb, aLen - da);
+      fillSpan(alongX, a0, b, da, c);
+    } else {
+      moveSpan(alongX, a0, b, a0 - da, sb, aLen + da);
+      fillSpan(alongX, a0 + aLen + da, b, -da, c);
+    }
+  }
+}
+
+void IRM_Mini::rotateContent(int16_t dx, int16_t dy) {
+  rotateContent(0, 0, _width, _height, dx, dy);
+}
+
+void IRM_Mini::rotateContent(int16_t x, int16_t y, int16_t w, int16_t h,
+                             int16_t dx, int16_t dy) {
+  if (!clipRegion(x, y, w, h))
+    return;
+  if (!lineBuf &&
+      !(lineBuf = (uint8_t *)allocBuffer(max(WIDTH, HEIGHT) * 4)))
+    return;
+
+  bool alongX = linesAlongX();
+  int16_t a0 = alongX ? x : y, aLen = alongX ? w : h, da = alongX ? dx : dy;
+  int16_t b0 = alongX ? y : x, bLen = alongX ? h : w, db = alongX ? dy : dx;
+  da %= aLen;
+  if (da < 0)
+    da += aLen;
+  db %= bLen;
+  if (db < 0)
+    db += bLen;
+
+  if (db) {
+    // Cycle whole lines, one line of scratch per cycle ("juggling")
+    int16_t cycles = bLen, r = db;
+    while (r) {
+      int16_t t = cycles % r;
+      cycles = r;
+      r = t;
+    }
+    for (int16_t start = 0; start < cycles; start++) {
+      copySpan(alongX, a0, b0 + start, aLen, true);
+      int16_t j = start;
+      for (;;) {
+        int16_t src = j - db;
+        if (src < 0)
+          src += bLen;
+        if (src == start)
+          break;
+        moveSpan(alongX, a0, b0 + j, a0, b0 + src, aLen);
+        j = src;
+      }
+      copySpan(alongX, a0, b0 + j, aLen, false);
+    }
+  }
+
+  if (da) {
+    for (int16_t b = b0; b < b0 + bLen; b++) {
+      copySpan(alongX, a0 + aLen - da, b, da, true);
+      moveSpan(alongX, a0 + da, b, a0, b, aLen - da);
+      copySpan(alongX, a0, b, da, false);
+    }
+  }
+}
+
+void IRM_Mini::setFrameRate(uint8_t fps) {
+  frameMs = fps ? (1000 + fps / 2) / fps : 0;
+  clockRunning = false; // Restart the schedule from the next tick()
+}
+
+void IRM_Mini::addWidget(IRM_Widget *w) {
+  IRM_Widget **p = &widgets;
+  while (*p) {
+    if (*p == w)
+      return;
+    p = &(*p)->nextWidget;
+  }
+  w->nextWidget = NULL;
+  *p = w;
+}
+
+void IRM_Mini::removeWidget(IRM_Widget *w) {
+  for (IRM_Widget **p = &widgets; *p; p = &(*p)->nextWidget) {
+    if (*p == w) {
+      *p = w->nextWidget;
+      w->nextWidget = NULL;
+      return;
+    }
+  }
+}
+
+bool IRM_Mini::tick(uint32_t now) {
+  if (!clockRunning) {
+    nextFrame = lastFrame = now;
+    clockRunning = true;
+  }
+  if ((int32_t)(now - nextFrame) < 0)
+    return false;
+
+  uint32_t late = now - nextFrame;
+  if (frameMs && (late >= frameMs)) {
+    // Overran: skip the missed slots instead of rendering them late
+    uint32_t missed = late / frameMs;
+    stats.dropped += missed;
+    nextFrame += missed * frameMs;
+    late -= missed * frameMs;
+  }
+  nextFrame += frameMs;
+  stats.jitterMs = (late > 0xFFFF) ? 0xFFFF : late;
+  if (stats.jitterMs > stats.maxJitterMs)
+    stats.maxJitterMs = stats.jitterMs;
+
+  uint32_t dt = now - lastFrame;
+  lastFrame = now;
+  IRM_Widget *w;
+  for (w = widgets; w; w = w->nextWidget)
+    w->update(dt);
 
-  c = passThruFlag ? passThruColor : expandColor(color);
-  n = numPixels();
-  for (i = 0; i < n; i++)
-    setPixelColor(i, c);
+  uint32_t t0 = micros();
+  for (w = widgets; w; w = w->nextWidget)
+    w->render(*this);
+  show();
+  stats.frameTimeUs = micros() - t0;
+  if (stats.frameTimeUs > stats.maxFrameTimeUs)
+    stats.maxFrameTimeUs = stats.frameTimeUs;
+  stats.frames++;
+  return true;
 }
 
-void IRM_Mini::setRemapFunction(uint16_t (*fn)(uint16_t, uint16_t)) {
+void IRM_Mini::resetFrameStats(void) { memset(&stats, 0, sizeof(stats)); }
+
+bool IRM_Mini::setRemapFunction(uint16_t (*fn)(uint16_t, uint16_t)) {
+  if (fn && !setFramebuffer(IRM_FB_LED)) // Can't be walked in chain order
+    return false;
   remapFn = fn;
+  return true;
 }
 
+// Every overload funnels into the const char* version, so no String
+// temporaries are built on the heap just to draw text.
 void IRM_Mini::drawAscii(uint16_t x, uint16_t y, char text, uint16_t color, uint8_t fontSize) {
-  this->drawAscii(x, y, String(text), color, fontSize);
+  char str[2] = {text, 0};
+  this->drawAscii(x, y, (const char *)str, color, fontSize);
 }
 void IRM_Mini::drawAscii(uint16_t x, uint16_t y, char* text, uint16_t color, uint8_t fontSize) {
-  this->drawAscii(x, y, String(text), color, fontSize);
+  this->drawAscii(x, y, (const char *)text, color, fontSize);
 }
+void IRM_Mini::drawAscii(uint16_t x, uint16_t y, const String &text, uint16_t color, uint8_t fontSize) {
+  this->drawAscii(x, y, text.c_str(), color, fontSize);
+}
+
 void IRM_Mini::drawAscii(uint16_t x, uint16_t y, const char* text, uint16_t color, uint8_t fontSize) {
-  this->drawAscii(x, y, String(text), color, fontSize);
-}
-
-void IRM_Mini::drawAscii(uint16_t x, uint16_t y, String text, uint16_t color, uint8_t fontSize) {
-  uint8_t* bitmap;
-  for (uint8_t i=0; i<text.length(); i++) {
-    uint8_t asciiValue = text[i] - 32 + 1;
-    if (asciiValue < 0) asciiValue = 0;
-    switch (fontSize) {
-      case FONT7: bitmap = (uint8_t*)FONT7_BITMAT[asciiValue]; break;
-      case FONT5: bitmap = (uint8_t*)FONT5_BITMAT[asciiValue]; break;
-      default: Serial.println("Unknown font size"); while(1); break;
-    }
-    uint8_t width = bitmap[0];
-    this->fillRect(x, y, x+width, y+fontSize, 0);
-    uint8_t fontSizeOffset = fontSize - fontSize;
-    for (uint8_t j=1; j<=fontSize; j++) {
-      uint8_t line = bitmap[j];
+  uint8_t rows[FONT7];
+  for (uint8_t i=0; text[i]; i++) {
+    uint8_t width = glyph(text[i], fontSize, rows);
+    if (!width) { Serial.println("Unknown font size"); while(1); }
+    this->fillRect(x, y, width, fontSize, 0);
+    for (uint8_t j=0; j<fontSize; j++) {
+      uint8_t line = rows[j];
       for (uint8_t k=0; k<width; k++) {
         if (line & (1 << k)) {
-          this->drawPixel(x+width-k-1, y+j+fontSizeOffset-1, color);
+          this->drawPixel(x+width-k-1, y+j, color);
         }
       }
     }
     x += width;
-    this->fillRect(x, y, x+1, y+fontSize, 0);
+    this->fillRect(x, y, 1, fontSize, 0);
     x += 1;
   }
 }
 
+void IRM_Mini::drawAscii(uint16_t x, uint16_t y, const char *text,
+                         uint16_t color, const IRM_Asset &font) {
+  if (!font.pack || (font.format != IRM_ASSET_FONT))
+    return;
+  for (; *text; text++) {
+    uint8_t c = *text;
+    if ((c < font.base) || (c - font.base >= font.frames))
+      continue;
+    uint8_t width;
+    if (!font.pack->read(font, (c - font.base) * font.frameSize(), &width, 1))
+      return;
+    fillRect(x, y, width + 1, font.height, 0);
+    drawAsset(x, y, font, c - font.base, color);
+    x += width + 1;
+  }
+}
+
+// Glyphs are packed LSB first: 3-bit width, then 5-bit rows
+uint8_t IRM_Mini::glyph(char c, uint8_t fontSize, uint8_t *rows) {
+  uint8_t index = ((c < ' ') || (c > '~')) ? 0 : c - 32 + 1;
+  const uint8_t *p;
+  switch (fontSize) {
+    case FONT7: p = &IRM_PackedFont<Font7>::glyphs[index * Font7::bytes]; break;
+    case FONT5: p = &IRM_PackedFont<Font5>::glyphs[index * Font5::bytes]; break;
+    default: return 0;
+  }
+  uint16_t bits = pgm_read_byte(p++);
+  uint8_t have = 8;
+  uint8_t width = bits & 0x07;
+  bits >>= 3;
+  have -= 3;
+  for (uint8_t j = 0; j < fontSize; j++) {
+    if (have < 5) {
+      bits |= (uint16_t)pgm_read_byte(p++) << have;
+      have += 8;
+    }
+    rows[j] = bits & 0x1F;
+    bits >>= 5;
+    have -= 5;
+  }
+  return width;
+}
+
 // Draw a RGB 8bit bitmap
 void IRM_Mini::drawRGBBitmap(int16_t startx, int16_t starty, const uint32_t *bitmap, int16_t w, int16_t h, bool cover) {
   // work around "a15 cannot be used in asm here" compiler bug when using an array on ESP8266
@@ -487,3 +1878,91 @@ void IRM_Mini::drawRGBBitmap(int16_t startx, int16_t starty, const uint32_t *bit
     }
   }
 }
+
+// Runs of set bits in a 1-bit row (MSB leftmost) are filled as spans
+void IRM_Mini::drawBits(int16_t x, int16_t y, const uint8_t *bits, uint16_t w,
+                        uint16_t color) {
+  uint16_t i = 0;
+  while (i < w) {
+    if (!(bits[i >> 3] & (0x80 >> (i & 7)))) {
+      i++;
+      continue;
+    }
+    uint16_t start = i;
+    while ((i < w) && (bits[i >> 3] & (0x80 >> (i & 7))))
+      i++;
+    fillRect(x + start, y, i - start, 1, color);
+  }
+}
+
+bool IRM_Mini::drawAsset(int16_t x, int16_t y, const IRM_Asset &asset,
+                         uint16_t frame, uint16_t color) {
+  const IRM_AssetPack *pack = asset.pack;
+  if (!pack || ((asset.format != IRM_ASSET_QOI) && (frame >= asset.frames)))
+    return false;
+  const uint8_t *mapped = pack->map(asset);
+  uint32_t off = (uint32_t)frame * asset.frameSize();
+  int16_t w = asset.width, h = asset.height;
+
+  switch (asset.format) {
+  case IRM_ASSET_RGB565: {
+    uint16_t buf[32];
+    for (int16_t j = 0; j < h; j++, off += w * 2) {
+      if ((y + j < 0) || (y + j >= _height))
+        continue;
+      if (mapped) {
+        drawRow(x, y + j, (const uint16_t *)(mapped + off), w);
+        continue;
+      }
+      for (int16_t i = max(0, -x) & ~31; (i < w) && (x + i < _width);
+           i += 32) {
+        int16_t n = min(32, w - i);
+        if (pack->read(asset, off + i * 2, (uint8_t *)buf, n * 2) !=
+            (size_t)n * 2)
+          return false;
+        drawRow(x + i, y + j, buf, n);
+      }
+    }
+    return true;
+  }
+
+  case IRM_ASSET_FONT:
+    off++; // Past the glyph width
+    // Fall through
+  case IRM_ASSET_MONO: {
+    uint8_t bits[32];
+    uint16_t stride = (w + 7) >> 3;
+    if (stride > sizeof(bits))
+      return false;
+    for (int16_t j = 0; j < h; j++, off += stride) {
+      if ((y + j < 0) || (y + j >= _height))
+        continue;
+      const uint8_t *row = mapped ? mapped + off : bits;
+      if (!mapped && (pack->read(asset, off, bits, stride) != stride))
+        return false;
+      drawBits(x, y + j, row, w, color);
+    }
+    return true;
+  }
+
+  case IRM_ASSET_QOI: {
+    IRM_QoiDecoder qoi(*this);
+    if (mapped)
+      return qoi.draw(x, y, mapped, asset.size, false);
+    uint8_t buf[32];
+    qoi.begin(x, y);
+    for (uint32_t i = 0; (i < asset.size) && !qoi.done() && !qoi.failed();) {
+      size_t n = pack->read(asset, i, buf, sizeof(buf));
+      if (!n)
+        return false;
+      for (size_t k = 0; k < n; k++)
+        qoi.feed(buf[k]);
+      i += n;
+    }
+    return qoi.done();
+  }
+
+  default:
+    return false;
+  }
+}
@@ -42,6 +42,7 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_NeoPixel.h>
 #include "ascii.h"
+#include "irm_port.h"
 
 // Matrix layout information is passed in the 'matrixType' parameter for
 // each constructor (the parameter immediately following is the LED type
@@ -80,6 +81,162 @@
 #define FONT7 7
 #define FONT5 5
 
+#define IRM_CAL_TILE 0  ///< One calibration gain triplet per tile
+#define IRM_CAL_PIXEL 1 ///< One calibration gain triplet per LED
+
+#define IRM_FB_LED 0     ///< Draw straight into the LED buffer (default)
+#define IRM_FB_RGB565 16 ///< 16-bit '565' framebuffer, see setFramebuffer()
+#define IRM_FB_PAL8 8    ///< 8-bit palette indices, see setFramebuffer()
+
+#define IRM_FADE 0       ///< Crossfade, see startTransition()
+#define IRM_WIPE_RIGHT 1 ///< New frame sweeps in from the left edge
+#define IRM_WIPE_LEFT 2  ///< New frame sweeps in from the right edge
+#define IRM_WIPE_DOWN 3  ///< New frame sweeps in from the top
+#define IRM_WIPE_UP 4    ///< New frame sweeps in from the bottom
+#define IRM_DISSOLVE 5   ///< LEDs switch over in pseudo-random order
+
+class IRM_Mini;
+class IRM_Pipeline;
+struct IRM_Asset;
+
+/**
+ * @brief Base class for effects and widgets driven by IRM_Mini::tick().
+ *        Widgets are kept in an intrusive list, so registering one
+ *        allocates nothing.
+ */
+class IRM_Widget {
+public:
+  virtual ~IRM_Widget() {}
+
+  /**
+   * @brief  Advance animation state. Called once per frame before any
+   *         widget renders, with the real time elapsed (dropped frames
+   *         included) so motion stays in step with the clock.
+   * @param  dt  Milliseconds since the previous frame.
+   */
+  virtual void update(uint32_t dt) { (void)dt; }
+
+  /**
+   * @brief  Draw the widget. Widgets render in registration order.
+   * @param  matrix  Display being rendered.
+   */
+  virtual void render(IRM_Mini &matrix) = 0;
+
+private:
+  friend class IRM_Mini;
+  IRM_Widget *nextWidget = NULL;
+};
+
+/**
+ * @brief Layout of the LED buffer, see IRM_Mini::pixelFormat().
+ */
+struct IRM_PixelFormat {
+  uint8_t bpp;        ///< Bytes per LED, 3 or 4
+  uint8_t r, g, b, w; ///< Byte offset of each channel (w == r: no white)
+};
+
+/**
+ * @brief Where IRM_Mini::show() sends frames, instead of the matrix's own
+ *        NeoPixel pin (see IRM_Mini::setOutput()). Drawing always fills
+ *        the same LED buffer, in the byte order the matrix was constructed
+ *        with; an output converts it to its chip's format in one pass as
+ *        it sends, so the drawing code doesn't depend on the LED type.
+ */
+class IRM_Output {
+public:
+  virtual ~IRM_Output() {}
+
+  /**
+   * @brief  Attach to a matrix; called by IRM_Mini::setOutput(), which
+   *         sets matrix first so buffers can come from its allocBuffer().
+   * @param  format   LED buffer layout.
+   * @param  numLEDs  LEDs in the chain.
+   * @return false if the output can't be used (e.g. out of memory).
+   */
+  virtual bool begin(const IRM_PixelFormat &format, uint16_t numLEDs) {
+    fmt = format;
+    leds = numLEDs;
+    return true;
+  }
+
+  /**
+   * @brief  A frame starts.
+   * @param  count  LEDs it will hold; fewer than the chain after a
+   *                partial show().
+   */
+  virtual void beginFrame(uint16_t count) { (void)count; }
+
+  /**
+   * @brief  Next LEDs of the frame, in chain order. IRM_Mini writes a
+   *         whole frame at once, except from a framebuffer mode, which
+   *         writes one line at a time if chunkedWrites() allows it.
+   * @param  data   LED data, in the begin() format.
+   * @param  count  LEDs in data.
+   */
+  virtual void write(const uint8_t *data, uint16_t count) = 0;
+
+  /**
+   * @brief  The frame is complete; latch it.
+   */
+  virtual void endFrame(void) {}
+
+  /**
+   * @brief  Send a whole frame: beginFrame(), write(), endFrame().
+   * @param  data   LED data, in the begin() format.
+   * @param  count  LEDs in data.
+   */
+  void send(const uint8_t *data, uint16_t count) {
+    beginFrame(count);
+    write(data, count);
+    endFrame();
+  }
+
+  /**
+   * @brief  Whether frames may stop before the end of the chain, as
+   *         partial show() sends them (see IRM_Mini::setPartialShow()).
+   * @return false if the output needs whole frames.
+   */
+  bool partialFrames(void) const { return partialOK; }
+
+  /**
+   * @brief  Whether a frame may arrive in several write() calls.
+   * @return false if each frame must come in a single write().
+   */
+  bool chunkedWrites(void) const { return chunkOK; }
+
+protected:
+  /**
+   * @brief  Convert LED data to plain R, G, B (and W) bytes.
+   * @param  src    LED data, in the begin() format.
+   * @param  dst    Receives count * 3 bytes (* 4 with W).
+   * @param  count  LEDs to convert.
+   * @param  withW  Also output W (0 if the buffer has none).
+   */
+  void toRGB(const uint8_t *src, uint8_t *dst, uint16_t count,
+             bool withW = false) const;
+
+  IRM_PixelFormat fmt = {3, 1, 0, 2, 1}; ///< LED buffer layout
+  uint16_t leds = 0;                     ///< LEDs in the chain
+  bool partialOK = true; ///< Frames shorter than the chain are fine
+  bool chunkOK = true;   ///< Frames may be written in pieces
+  IRM_Mini *matrix = NULL; ///< Attached matrix, for its allocBuffer()
+
+private:
+  friend class IRM_Mini;
+};
+
+/**
+ * @brief Frame clock statistics, see IRM_Mini::frameStats().
+ */
+struct IRM_FrameStats {
+  uint32_t frames;         ///< Frames rendered
+  uint32_t dropped;        ///< Frame slots skipped because we ran late
+  uint32_t frameTimeUs;    ///< Render + show() time of the last frame
+  uint32_t maxFrameTimeUs; ///< Worst render + show() time
+  uint16_t jitterMs;       ///< How late the last frame started
+  uint16_t maxJitterMs;    ///< Worst start lateness
+};
+
 /**
  * @brief Class for using NeoPixel matrices with the GFX graphics library.
  */
@@ -121,6 +278,380 @@ public:
                                           NEO_TILE_LEFT + NEO_TILE_ROWS,
                      neoPixelType ledType = NEO_GRB + NEO_KHZ800);
 
+  ~IRM_Mini();
+
+  /**
+   * @brief  Initialize the NeoPixel output, LED buffer on the heap. A
+   *         snapshot from setSnapshotMemory() is restored and shown.
+   */
+  void begin(void);
+
+  /**
+   * @brief  Initialize the NeoPixel output and move the LED buffer into a
+   *         caller-supplied arena. Every buffer the library needs later
+   *         (tables, back buffers, caches, scratch) is carved from the same
+   *         arena, so nothing calls malloc() at runtime. The arena is never
+   *         freed; don't call updateLength() or updateType() afterwards.
+   * @param  arena  Static memory to allocate from, e.g. a global array.
+   * @param  size   Size of arena in bytes.
+   * @return true on success, false if the arena can't hold the LED buffer
+   *         (the heap buffer is kept in that case).
+   */
+  bool begin(void *arena, size_t size);
+
+  /**
+   * @brief  Allocate a library buffer, from the arena if one was given to
+   *         begin(), else from the heap.
+   * @param  bytes  Size in bytes.
+   * @return Pointer aligned to 4 bytes, or NULL if out of memory.
+   */
+  void *allocBuffer(size_t bytes);
+
+  /**
+   * @brief  Release a buffer from allocBuffer(). Arena memory is only
+   *         reclaimed when buf is the most recent allocation.
+   * @param  buf  Buffer to release (NULL is ignored).
+   */
+  void freeBuffer(void *buf);
+
+  /**
+   * @brief  Arena usage, for sizing the arena per product.
+   * @return Bytes currently allocated from the arena.
+   */
+  size_t arenaUsed(void) const { return arenaTop; }
+
+  /**
+   * @brief  Arena high-water mark.
+   * @return Most bytes ever allocated from the arena at once.
+   */
+  size_t arenaHighWater(void) const { return arenaPeak; }
+
+  /**
+   * @brief  Arena size.
+   * @return Size passed to begin(), 0 when running from the heap.
+   */
+  size_t arenaSize(void) const { return arenaLen; }
+
+  /**
+   * @brief  Transmit the LED buffer. With partial show enabled, only the
+   *         chain up to the end of the last dirty tile is sent; LEDs past
+   *         that point keep their previous state. With an IRM_Pipeline
+   *         running, the frame is queued for the output task instead.
+   */
+  void show(void);
+
+  /**
+   * @brief  Enable or disable dirty-tile tracking and partial show().
+   *         Pixels written with setPixelColor() bypass the tracking; call
+   *         markAllDirty() after doing so.
+   * @param  on  true to only send the changed head of the chain.
+   * @return false if the dirty-tile map couldn't be allocated, or in a
+   *         framebuffer mode.
+   */
+  bool setPartialShow(bool on);
+
+  /**
+   * @brief  Force the next show() to send the whole chain.
+   */
+  void markAllDirty(void);
+
+  /**
+   * @brief  Query the dirty map (tiles in chain order; for untiled
+   *         matrices each line along the major axis counts as a tile).
+   * @param  tile  Tile number in chain order.
+   * @return true if the tile changed since the last show().
+   */
+  bool isTileDirty(uint16_t tile) const;
+
+  /**
+   * @brief  LEDs skipped by the most recent show().
+   * @return Number of LEDs at the end of the chain that weren't sent.
+   */
+  uint16_t lastSavedLEDs(void) const { return savedLEDs; }
+
+  /**
+   * @brief  Correct color differences between LED batches. Gains are
+   *         applied to a copy of the LED buffer as show() sends it, so
+   *         drawing, getPixelColor() and partial show() still work on the
+   *         uncorrected colors. In a framebuffer mode lines are corrected
+   *         as they are encoded, and no copy is allocated until
+   *         setFramebuffer() returns to IRM_FB_LED. extras/irm_calib.c
+   *         makes tables from measurements.
+   * @param  gains    R, G, B gains (255 = unchanged, 0 = off), one triplet
+   *                  per tile (IRM_CAL_TILE) or per LED (IRM_CAL_PIXEL), in
+   *                  chain order. NULL turns calibration off.
+   * @param  mode     IRM_CAL_TILE or IRM_CAL_PIXEL.
+   * @param  progmem  true if gains are in PROGMEM, false if in RAM (e.g.
+   *                  read back from EEPROM).
+   * @return false if the output copy couldn't be allocated.
+   */
+  bool setCalibration(const uint8_t *gains, uint8_t mode = IRM_CAL_TILE,
+                      bool progmem = true);
+
+  /**
+   * @brief  Start a transition from what's on the display now to what's
+   *         drawn from here on. The current frame is copied aside; keep
+   *         drawing the new scene as usual (it may animate) and each
+   *         show() sends a mix of the two for the given time. Every
+   *         show() makes one pass over the raw LED bytes with no
+   *         per-pixel mapping: the crossfade moves each byte towards the
+   *         live frame, wipes copy chain-contiguous runs, and the dissolve
+   *         walks a maximal-length LFSR over the chain so every LED
+   *         switches exactly once. Starting another transition mid-way
+   *         continues from the current mix. The copy is allocated by the
+   *         first transition and kept for later ones, until
+   *         setFramebuffer() changes mode. LED mode only, without an
+   *         IRM_Pipeline.
+   * @param  type  IRM_FADE, IRM_WIPE_RIGHT, IRM_WIPE_LEFT, IRM_WIPE_DOWN,
+   *               IRM_WIPE_UP or IRM_DISSOLVE.
+   * @param  ms    Duration in milliseconds.
+   * @return false if the copy couldn't be allocated, or in a framebuffer
+   *         mode or with a pipeline.
+   */
+  bool startTransition(uint8_t type, uint16_t ms);
+
+  /**
+   * @brief  Whether a transition is running.
+   * @return true until the show() that completes it.
+   */
+  bool inTransition(void) const { return transOn; }
+
+  /**
+   * @brief  Cut to the new frame now; the next show() sends it as is.
+   */
+  void endTransition(void);
+
+  /**
+   * @brief  Keep a compressed copy of the frame in memory that survives
+   *         deep sleep (declare it IRM_RETAINED), and bring it back at
+   *         begin(): a valid snapshot is decoded straight into the LED
+   *         buffer and shown before begin() returns, so the panel shows
+   *         the last image within milliseconds of waking. The buffer keeps
+   *         that frame, so the sketch can draw just what changes as fresh
+   *         data arrives (skip the usual clear when snapshotRestored()).
+   *         Call before begin(). LED mode only; not with a pipeline.
+   * @param  mem       Retained memory, e.g. IRM_RETAINED uint8_t
+   *                   snap[1024] (RTC slow memory on ESP32), or
+   *                   irmRetainedMemory() on a Linux host.
+   * @param  size      Size of mem in bytes.
+   * @param  autoSave  Snapshot every frame as show() sends it. Otherwise
+   *                   call saveSnapshot() before going to sleep.
+   */
+  void setSnapshotMemory(void *mem, size_t size, bool autoSave = true);
+
+  /**
+   * @brief  Compress the LED buffer into the snapshot memory. Runs of
+   *         identical LEDs cost 1 + 3 (RGBW: 4) bytes, so dark or flat
+   *         frames fit in a fraction of the buffer size.
+   * @return false if there's no snapshot memory or the frame doesn't fit;
+   *         the memory then holds no snapshot rather than a stale one.
+   */
+  bool saveSnapshot(void);
+
+  /**
+   * @brief  Load the snapshot into the LED buffer (begin() does this).
+   * @return false if there is no valid snapshot for this matrix (wrong
+   *         size or LED type, or memory that was never written: power-on
+   *         garbage fails the CRC).
+   */
+  bool restoreSnapshot(void);
+
+  /**
+   * @brief  Whether begin() restored a snapshot.
+   * @return true if the LED buffer holds the retained frame.
+   */
+  bool snapshotRestored(void) const { return snapRestored; }
+
+  /**
+   * @brief  Check whether the LED buffer holds plain R,G,B bytes at full
+   *         brightness (NEO_RGB, no setBrightness()), so 24-bit RGB data
+   *         from elsewhere can be copied straight into getPixels().
+   * @return true if RGB data can be copied in unchanged.
+   */
+  bool isRawRGB(void) const {
+    return !fb && pixels && !brightness && (wOffset == rOffset) &&
+           (rOffset == 0) && (gOffset == 1) && (bOffset == 2);
+  }
+
+  /**
+   * @brief  The LED buffer, for writing pixel data into directly (as
+   *         IRM_NetSink and IRM_StreamDecoder do). In framebuffer modes
+   *         the LED buffer is only scratch for show(), or is released, so
+   *         there is none to write to.
+   * @return LED buffer, or NULL in a framebuffer mode.
+   */
+  uint8_t *getPixels(void) const { return fb ? NULL : pixels; }
+
+  /**
+   * @brief  Layout of the LED buffer, as set by the constructor's LED
+   *         type.
+   * @return Bytes per LED and channel offsets.
+   */
+  IRM_PixelFormat pixelFormat(void) const;
+
+  /**
+   * @brief  Send frames to an output instead of this matrix's NeoPixel
+   *         pin. Set it before starting a pipeline.
+   * @param  out  Output, or NULL for the NeoPixel pin again.
+   * @return false if out->begin() failed, or the LED buffer released by
+   *         setFramebuffer() couldn't be reallocated; the previous output
+   *         stays.
+   */
+  bool setOutput(IRM_Output *out);
+
+  /**
+   * @brief  Choose what drawing writes to. IRM_FB_RGB565 keeps a 16-bit
+   *         '565' framebuffer in display order (row-major, width() pixels
+   *         per row, current rotation), so drawPixel() is a single store
+   *         with no mapping. show() then encodes the frame in chain order,
+   *         applying layout, gamma, brightness and calibration in one pass.
+   *         If an output that takes chunked writes (e.g. IRM_APA102Output)
+   *         is set first, frames are encoded a line at a time and the heap
+   *         LED buffer is released, a third less RAM than 24-bit; the
+   *         NeoPixel pin needs whole frames, so there the LED buffer stays
+   *         as scratch for the encoded frame. The framebuffer starts
+   *         black; switching back to IRM_FB_LED keeps the picture.
+   *         IRM_FB_PAL8 stores one byte per pixel instead, an index into
+   *         a 256-entry palette of 24-bit colors (see setPalette()); the
+   *         low byte of every drawing color is the index. Changing the
+   *         palette changes every pixel using it at the next show(),
+   *         without redrawing. Switching between the two framebuffer
+   *         modes goes through IRM_FB_LED.
+   *         Pass-through color, partial show and IRM_Pipeline aren't
+   *         available in framebuffer modes. getPixels() returns NULL in
+   *         them, so IRM_NetSink and IRM_StreamDecoder drop what they
+   *         receive. setRemapFunction() returns to IRM_FB_LED.
+   * @param  mode  IRM_FB_LED, IRM_FB_RGB565 or IRM_FB_PAL8.
+   * @return false if out of memory or the layout is remapped.
+   */
+  bool setFramebuffer(uint8_t mode);
+
+  /**
+   * @brief  Current framebuffer mode.
+   * @return IRM_FB_LED, IRM_FB_RGB565 or IRM_FB_PAL8.
+   */
+  uint8_t framebufferMode(void) const { return fbMode; }
+
+  /**
+   * @brief  Framebuffer of a framebuffer mode, for code that renders
+   *         into it directly (cast to uint16_t * for IRM_FB_RGB565).
+   * @return Pixel data, NULL in IRM_FB_LED mode.
+   */
+  uint8_t *getFramebuffer(void) { return fb; }
+
+  /**
+   * @brief  Load palette entries for IRM_FB_PAL8. Colors are sent as
+   *         they are, so they should already be gamma corrected; a new
+   *         palette starts as a grey ramp (entry i = i, i, i).
+   * @param  rgb      R, G, B triplets.
+   * @param  first    First entry to load.
+   * @param  count    Entries to load, up to the end of the palette.
+   * @param  progmem  true if rgb is in PROGMEM, false if in RAM.
+   */
+  void setPalette(const uint8_t *rgb, uint8_t first = 0, uint16_t count = 256,
+                  bool progmem = true);
+
+  /**
+   * @brief  Set one palette entry.
+   * @param  i  Entry.
+   * @param  r  Red, 0-255 (gamma corrected).
+   * @param  g  Green, 0-255.
+   * @param  b  Blue, 0-255.
+   */
+  void setPaletteColor(uint8_t i, uint8_t r, uint8_t g, uint8_t b);
+
+  /**
+   * @brief  Set one palette entry from a '565' color, through the same
+   *         gamma tables as drawing in the other modes.
+   * @param  i      Entry.
+   * @param  color  Color in 16-bit '565' RGB format.
+   */
+  void setPaletteColor(uint8_t i, uint16_t color);
+
+  /**
+   * @brief  Read a palette entry.
+   * @param  i  Entry.
+   * @return Packed 0RGB color, 0 outside IRM_FB_PAL8.
+   */
+  uint32_t getPaletteColor(uint8_t i) const;
+
+  /**
+   * @brief  Cycle a range of palette entries, the classic way to animate
+   *         fire, water and rainbows without touching the pixels.
+   * @param  steps  Entries to move towards higher indices (negative =
+   *                lower); entries leaving one end of the range come back
+   *                at the other.
+   * @param  first  First entry of the range.
+   * @param  last   Last entry of the range.
+   */
+  void rotatePalette(int16_t steps, uint8_t first = 0, uint8_t last = 255);
+
+  /**
+   * @brief  Move palette entries part of the way towards a target palette
+   *         (or black), for fades. Each channel moves by at least one
+   *         step while it differs, so repeated calls always arrive.
+   * @param  target   R, G, B triplets for entries first.., or NULL for
+   *                  black.
+   * @param  amount   Fraction to move, 0-255 (255 = all the way).
+   * @param  first    First entry to fade.
+   * @param  count    Entries to fade.
+   * @param  progmem  true if target is in PROGMEM, false if in RAM.
+   */
+  void fadePalette(const uint8_t *target, uint8_t amount, uint8_t first = 0,
+                   uint16_t count = 256, bool progmem = true);
+
+  /**
+   * @brief  Set brightness, marking the whole chain dirty since every
+   *         LED is rescaled. See Adafruit_NeoPixel::setBrightness().
+   * @param  b  Brightness, 0 (off) to 255 (max).
+   */
+  void setBrightness(uint8_t b);
+
+  /**
+   * @brief  Clear the LED buffer, marking the whole chain dirty.
+   */
+  void clear(void);
+
+  /**
+   * @brief  Set the frame clock's target rate for tick().
+   * @param  fps  Frames per second, 0 renders on every tick().
+   */
+  void setFrameRate(uint8_t fps);
+
+  /**
+   * @brief  Register a widget or effect with the frame clock.
+   * @param  w  Widget to add; must outlive its registration.
+   */
+  void addWidget(IRM_Widget *w);
+
+  /**
+   * @brief  Unregister a widget.
+   * @param  w  Widget to remove.
+   */
+  void removeWidget(IRM_Widget *w);
+
+  /**
+   * @brief  Drive the frame clock; call from loop() with millis(). When a
+   *         frame is due, updates and renders every widget and calls
+   *         show(). If rendering overran by whole frames, those frames are
+   *         dropped rather than rendered late back-to-back, so networking
+   *         and other loop() work keep getting CPU time.
+   * @param  now  Current time in milliseconds.
+   * @return true if a frame was rendered.
+   */
+  bool tick(uint32_t now);
+
+  /**
+   * @brief  Frame clock statistics.
+   * @return Counters since construction or resetFrameStats().
+   */
+  const IRM_FrameStats &frameStats(void) const { return stats; }
+
+  /**
+   * @brief  Zero the frame clock statistics.
+   */
+  void resetFrameStats(void);
+
   /**
    * @brief  Pixel-drawing function for Adafruit_GFX.
    * @param  x      Pixel column (0 = left edge, unless rotation used).
@@ -129,12 +660,127 @@ public:
    */
   void drawPixel(int16_t x, int16_t y, uint16_t color);
 
+  /**
+   * @brief  Set display rotation for Adafruit_GFX. The rotation is folded
+   *         into the matrix/tile layout here, so drawing costs the same in
+   *         all four orientations.
+   * @param  r  Rotation, 0-3 (90 degree steps clockwise).
+   */
+  void setRotation(uint8_t r);
+
+  /**
+   * @brief  Map display coordinates to an LED index in the chain.
+   * @param  x  Pixel column, honouring rotation. Must be on-screen.
+   * @param  y  Pixel row, honouring rotation. Must be on-screen.
+   * @return LED index for setPixelColor() and friends.
+   */
+  uint16_t mapXY(int16_t x, int16_t y) const;
+
+  /**
+   * @brief  Scroll the whole display by moving pixel data already in the
+   *         LED buffer; only the exposed edge is filled, so a scroller
+   *         just draws the new column/row afterwards.
+   * @param  dx         Pixels to move right (negative = left).
+   * @param  dy         Pixels to move down (negative = up).
+   * @param  fillColor  Color for exposed pixels, 16-bit '565' RGB format.
+   */
+  void scroll(int16_t dx, int16_t dy, uint16_t fillColor = 0);
+
+  /**
+   * @brief  Scroll a rectangular region, see scroll(dx, dy, fillColor).
+   * @param  x          Region left edge.
+   * @param  y          Region top edge.
+   * @param  w          Region width.
+   * @param  h          Region height.
+   * @param  dx         Pixels to move right (negative = left).
+   * @param  dy         Pixels to move down (negative = up).
+   * @param  fillColor  Color for exposed pixels, 16-bit '565' RGB format.
+   */
+  void scroll(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx,
+              int16_t dy, uint16_t fillColor = 0);
+
+  /**
+   * @brief  Like scroll(), but pixels leaving one edge wrap around to the
+   *         opposite edge. Needs one line of scratch from allocBuffer()
+   *         the first time it's used.
+   * @param  dx  Pixels to move right (negative = left).
+   * @param  dy  Pixels to move down (negative = up).
+   */
+  void rotateContent(int16_t dx, int16_t dy);
+
+  /**
+   * @brief  Wrap-around scroll of a rectangular region.
+   * @param  x   Region left edge.
+   * @param  y   Region top edge.
+   * @param  w   Region width.
+   * @param  h   Region height.
+   * @param  dx  Pixels to move right (negative = left).
+   * @param  dy  Pixels to move down (negative = up).
+   */
+  void rotateContent(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx,
+                     int16_t dy);
+
   /**
    * @brief  Fill matrix with a single color.
    * @param  color  Pixel color in 16-bit '565' RGB format.
    */
   void fillScreen(uint16_t color);
 
+  /**
+   * @brief  Fill a rectangle. Runs of LEDs that are consecutive in the
+   *         chain are filled as blocks, with the color converted to its
+   *         wire bytes once. Adafruit_GFX's filled shapes and lines end
+   *         up here too.
+   * @param  x      Left edge.
+   * @param  y      Top edge.
+   * @param  w      Width.
+   * @param  h      Height.
+   * @param  color  Pixel color in 16-bit '565' RGB format.
+   */
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+
+  /**
+   * @brief  Draw a row of pixels, e.g. a line of a decoded image. Clipped
+   *         like drawPixel(), but the layout is worked out once per run
+   *         of LEDs that are consecutive in the chain rather than once per
+   *         pixel.
+   * @param  x       Left edge.
+   * @param  y       Row.
+   * @param  colors  w pixel colors in 16-bit '565' RGB format (palette
+   *                 indices in IRM_FB_PAL8 mode).
+   * @param  w       Number of pixels.
+   */
+  void drawRow(int16_t x, int16_t y, const uint16_t *colors, int16_t w);
+
+  /**
+   * @brief  Draw scattered pixels, e.g. particles or plotted points, in
+   *         one call. Clipped like drawPixel(), but the checks for
+   *         framebuffer, pass-through and layout are made once per batch,
+   *         pixels are mapped inline rather than through mapXY() (unless
+   *         a remap function is set), and a color repeated from the
+   *         previous pixel isn't converted again.
+   * @param  xs      n pixel columns.
+   * @param  ys      n pixel rows.
+   * @param  colors  n pixel colors in 16-bit '565' RGB format (palette
+   *                 indices in IRM_FB_PAL8 mode).
+   * @param  n       Number of pixels.
+   */
+  void drawPixels(const int16_t *xs, const int16_t *ys,
+                  const uint16_t *colors, uint16_t n);
+
+  /**
+   * @brief  Draw scattered pixels all in one color, which is converted to
+   *         its wire bytes once.
+   * @param  xs     n pixel columns.
+   * @param  ys     n pixel rows.
+   * @param  n      Number of pixels.
+   * @param  color  Pixel color in 16-bit '565' RGB format.
+   */
+  void drawPixels(const int16_t *xs, const int16_t *ys, uint16_t n,
+                  uint16_t color);
+
   /**
    * @brief  Pass-through is a kludge that lets you override the current
    *         drawing color with a 'raw' RGB (or RGBW) value that's issued
@@ -162,8 +808,10 @@ public:
    *         NEO_TILE_* settings do not provide sufficient control).
    * @param  fn  Pointer to function that accepts two uint16_t arguments
    *             (column and row), returns absolute pixel index.
+   * @return false if a framebuffer mode couldn't be left (out of memory
+   *         for the LED buffer); the layout is unchanged.
    */
-  void setRemapFunction(uint16_t (*fn)(uint16_t, uint16_t));
+  bool setRemapFunction(uint16_t (*fn)(uint16_t, uint16_t));
 
   /**
    * @brief   Quantize a 24-bit RGB color value to 16-bit '565' format.
@@ -184,9 +832,50 @@ public:
    */
   void drawAscii(uint16_t x, uint16_t y, char text, uint16_t color, uint8_t fontSize);
   void drawAscii(uint16_t x, uint16_t y, char* text, uint16_t color, uint8_t fontSize);
-  void drawAscii(uint16_t x, uint16_t y, String text, uint16_t color, uint8_t fontSize);
+  void drawAscii(uint16_t x, uint16_t y, const String &text, uint16_t color, uint8_t fontSize);
   void drawAscii(uint16_t x, uint16_t y, const char* text, uint16_t color, uint8_t fontSize);
 
+  /**
+   * @brief  Draw text in a font from an asset pack (irm_asset.h), like
+   *         the built-in fonts: each glyph on black, with a black column
+   *         after it. Characters the font lacks are skipped.
+   * @param  x      Left edge.
+   * @param  y      Top edge.
+   * @param  text   ASCII text to draw.
+   * @param  color  Text color in 16-bit '565' RGB format.
+   * @param  font   IRM_ASSET_FONT asset.
+   */
+  void drawAscii(uint16_t x, uint16_t y, const char *text, uint16_t color,
+                 const IRM_Asset &font);
+
+  /**
+   * @brief  Draw an asset from an asset pack (irm_asset.h). Rows come
+   *         straight from mapped or RAM packs and go through drawRow();
+   *         other packs are read a few dozen bytes at a time. Nothing
+   *         frame-sized is allocated.
+   * @param  x      Left edge.
+   * @param  y      Top edge.
+   * @param  asset  IRM_ASSET_RGB565, IRM_ASSET_MONO, IRM_ASSET_FONT or
+   *                IRM_ASSET_QOI asset.
+   * @param  frame  Animation frame, or glyph index for a font.
+   * @param  color  Color of set pixels in MONO and FONT assets, 16-bit
+   *                '565' RGB format; clear pixels are left alone.
+   * @return false for a bad handle, frame, or format, or a failed read.
+   */
+  bool drawAsset(int16_t x, int16_t y, const IRM_Asset &asset,
+                 uint16_t frame = 0, uint16_t color = 0xFFFF);
+
+  /**
+   * @brief  Look up a character in the built-in fonts.
+   * @param  c         Character; anything outside ' '..'~' gives the
+   *                   error glyph.
+   * @param  fontSize  FONT5 or FONT7.
+   * @param  rows      Receives fontSize rows, top first. Bit 0 is the
+   *                   rightmost column.
+   * @return Glyph width in pixels, 0 for an unknown font size.
+   */
+  static uint8_t glyph(char c, uint8_t fontSize, uint8_t *rows);
+
   void drawRGBBitmap(int16_t startx, int16_t starty, const uint32_t *bitmap, int16_t w, int16_t h, bool cover=false);
 
 private:
@@ -194,8 +883,93 @@ private:
   const uint8_t matrixWidth, matrixHeight, tilesX, tilesY;
   uint16_t (*remapFn)(uint16_t x, uint16_t y);
 
+  // Layout as seen through the current rotation (see setRotation())
+  uint8_t rType, rMatrixW, rMatrixH, rTilesX, rTilesY;
+
+  friend class IRM_Pipeline;
+  IRM_Pipeline *pipeline = NULL; // Set while show() feeds a pipeline
+  IRM_Output *output = NULL;     // NULL = our own NeoPixel pin
+
   uint32_t passThruColor;
   boolean passThruFlag = false;
+
+  uint8_t *arena = NULL;     // Caller's memory, NULL = use heap
+  size_t arenaLen = 0;       // Arena size in bytes
+  size_t arenaTop = 0;       // Bytes allocated
+  size_t arenaLast = 0;      // Offset of most recent allocation
+  size_t arenaPeak = 0;      // High-water mark
+
+  uint8_t *dirtyTiles = NULL; // 1 bit per tile, NULL = partial show off
+  uint16_t dirtyUnit = 0;     // LEDs per tile
+  uint16_t dirtyEnd = 0;      // LEDs to send: end of last dirty tile
+  uint16_t savedLEDs = 0;     // LEDs skipped by last show()
+
+  const uint8_t *calGains = NULL; // Calibration table, NULL = off
+  uint8_t calMode = IRM_CAL_TILE;
+  bool calProgmem = true;
+  uint8_t *calBuf = NULL;         // Calibrated copy sent by show()
+
+  uint8_t *transBuf = NULL;   // Transition mix, kept once allocated
+  bool transOn = false;       // show() sends transBuf
+  uint8_t transType = IRM_FADE;
+  uint16_t transMs = 0;       // Duration
+  uint16_t transLevel = 0;    // Progress of the last step, 0-256
+  uint32_t transStart = 0;    // millis() at startTransition()
+
+  uint8_t *lineBuf = NULL;    // One line of LED data for rotateContent()
+
+  uint8_t *snapMem = NULL;    // Retained snapshot memory, NULL = none
+  size_t snapSize = 0;
+  bool snapAuto = false;      // Save on every show()
+  bool snapRestored = false;
+
+  uint8_t *fb = NULL;         // Framebuffer, NULL in IRM_FB_LED mode
+  uint8_t fbMode = IRM_FB_LED;
+  uint8_t *palette = NULL;    // IRM_FB_PAL8 colors, R, G, B per entry
+
+  IRM_Widget *widgets = NULL; // Frame clock widget list
+  uint16_t frameMs = 0;       // Frame period, 0 = every tick()
+  uint32_t nextFrame = 0;     // When the next frame is due
+  uint32_t lastFrame = 0;     // When the previous frame ran
+  bool clockRunning = false;
+  IRM_FrameStats stats = {};
+
+  bool linesAlongX(void) const;
+  uint16_t ledAt(bool alongX, int16_t a, int16_t b) const;
+  uint16_t runLength(bool alongX, int16_t a, bool forward) const;
+  void moveSpan(bool alongX, int16_t dstA, int16_t dstB, int16_t srcA,
+                int16_t srcB, int16_t n);
+  void fillSpan(bool alongX, int16_t a, int16_t b, int16_t n, uint32_t c);
+  void fillLEDs(uint16_t led, uint16_t n, uint32_t c);
+  void copySpan(bool alongX, int16_t a, int16_t b, int16_t n, bool save);
+  bool clipRegion(int16_t &x, int16_t &y, int16_t &w, int16_t &h) const;
+  void transmit(uint16_t n);
+  void calibrate(uint8_t *dst, const uint8_t *src, uint16_t n,
+                 uint16_t first = 0) const;
+  uint32_t spanColor(uint16_t color) const;
+  uint8_t pixelSize(void) const;
+  uint16_t chainLine(void) const;
+  void ledXY(uint16_t led, int16_t &x, int16_t &y) const;
+  void encodeLUT(uint8_t *lut) const;
+  void encodeLines(uint8_t *dst, uint16_t first, uint16_t count,
+                   const uint8_t *lut) const;
+  void streamFrame(void);
+  uint16_t stepTransition(void);
+  void copyRegion(uint8_t *dst, const uint8_t *src, int16_t x, int16_t y,
+                  int16_t w, int16_t h) const;
+  void drawBits(int16_t x, int16_t y, const uint8_t *bits, uint16_t w,
+                uint16_t color);
+  void plotPixels(const int16_t *xs, const int16_t *ys,
+                  const uint16_t *colors, uint16_t color, uint16_t n);
+
+  void markDirty(uint16_t led) {
+    if (dirtyTiles) {
+      uint16_t tile = led / dirtyUnit;
+      dirtyTiles[tile >> 3] |= 1 << (tile & 7);
+      if (led >= dirtyEnd)
+        dirtyEnd = (tile + 1) * dirtyUnit;
+    }
+  }
 };
 
 #endif // __IRM_MINI__
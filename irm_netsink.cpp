@@ -0,0 +1,290 @@
+/*!
+ * @file irm_netsink.cpp
+ *
+ * DDP / E1.31 receiver for IRM_Mini, see irm_netsink.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_netsink.h"
+
+#define DDP_VERSION_MASK 0xC0
+#define DDP_VERSION_1 0x40
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_FLAG_REPLY 0x04
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_PUSH 0x01
+#define DDP_ID_DISPLAY 1
+#define DDP_TYPE_RGB8 0x0B
+
+#define E131_HEADER_LEN 126
+#define E131_SYNC_LEN 49
+#define E131_VECTOR_ROOT_DATA 0x00000004
+#define E131_VECTOR_ROOT_EXTENDED 0x00000008
+#define E131_VECTOR_DATA_PACKET 0x00000002
+#define E131_VECTOR_SYNC 0x00000001
+#define E131_OPT_PREVIEW 0x80
+#define E131_OPT_TERMINATED 0x40
+
+#define SEEN_FRAME 0x01 // Universe arrived in the current frame
+#define SEEN_SEQ 0x02   // lastSeq holds a real sequence number
+
+static uint16_t be16(const uint8_t *p) { return ((uint16_t)p[0] << 8) | p[1]; }
+
+static uint32_t be32(const uint8_t *p) {
+  return ((uint32_t)be16(p) << 16) | be16(p + 2);
+}
+
+IRM_NetSink::IRM_NetSink(IRM_Mini &m) : matrix(m) {}
+
+bool IRM_NetSink::setUniverses(uint16_t first, uint16_t channels) {
+  if ((channels < 3) || (channels > 512))
+    return false;
+  firstUniverse = first;
+  universeChannels = channels - (channels % 3); // Whole pixels only
+  return true;
+}
+
+bool IRM_NetSink::begin(void) {
+  universes = ((uint32_t)matrix.numPixels() * 3 + universeChannels - 1) /
+              universeChannels;
+  if (lastSeq && (universes > seqUniverses)) { // Outgrew the last begin()
+    matrix.freeBuffer(lastSeq);
+    lastSeq = seen = NULL;
+  }
+  if (!lastSeq) {
+    if (!(lastSeq = (uint8_t *)matrix.allocBuffer(universes * 2))) {
+      seen = NULL;
+      return false;
+    }
+    seqUniverses = universes;
+  }
+  seen = lastSeq + universes;
+  memset(seen, 0, universes);
+  seenCount = 0;
+  return true;
+}
+
+// Returns 1 if the payload should be applied, 0 if the packet was dropped
+// or ignored, -1 if it was malformed.
+int8_t IRM_NetSink::parseHeader(const uint8_t *hdr, size_t len, Packet &p) {
+  p.push = p.sync = false;
+  p.universe = 0xFFFF;
+
+  if ((len >= 10) && ((hdr[0] & DDP_VERSION_MASK) == DDP_VERSION_1)) {
+    p.headerLen = (hdr[0] & DDP_FLAG_TIMECODE) ? 14 : 10;
+    if (len < p.headerLen) {
+      counters.errors++;
+      return -1;
+    }
+    if ((hdr[0] & (DDP_FLAG_QUERY | DDP_FLAG_REPLY)) ||
+        (hdr[3] != DDP_ID_DISPLAY))
+      return 0; // Status/config traffic, not pixels
+    if (hdr[2] && (hdr[2] != DDP_TYPE_RGB8)) {
+      counters.errors++;
+      return -1;
+    }
+    // 4-bit sequence, 0 = unused; anything 'behind' the last one is late
+    uint8_t seq = hdr[1] & 0x0F;
+    if (seq) {
+      if (ddpSeq && (((seq - ddpSeq) & 0x0F) >= 8)) {
+        counters.dropped++;
+        return 0;
+      }
+      ddpSeq = seq;
+    }
+    p.channel = be32(&hdr[4]);
+    p.length = be16(&hdr[8]);
+    p.push = hdr[0] & DDP_FLAG_PUSH;
+    counters.packets++;
+    return 1;
+  }
+
+  if ((len < E131_SYNC_LEN) || (be16(hdr) != 0x0010) ||
+      memcmp(&hdr[4], "ASC-E1.17", 9)) {
+    counters.errors++;
+    return -1;
+  }
+
+  uint32_t rootVector = be32(&hdr[18]);
+  if (rootVector == E131_VECTOR_ROOT_EXTENDED) {
+    if (be32(&hdr[40]) != E131_VECTOR_SYNC)
+      return 0; // Universe discovery etc.
+    p.headerLen = E131_SYNC_LEN;
+    p.length = 0;
+    p.sync = true;
+    p.push = syncAddress && (be16(&hdr[45]) == syncAddress);
+    counters.packets++;
+    return 1;
+  }
+
+  if ((rootVector != E131_VECTOR_ROOT_DATA) || (len < E131_HEADER_LEN) ||
+      (be32(&hdr[40]) != E131_VECTOR_DATA_PACKET) || (hdr[117] != 0x02) ||
+      (hdr[125] != 0)) { // DMX start code 0 only
+    counters.errors++;
+    return -1;
+  }
+  if (hdr[112] & (E131_OPT_PREVIEW | E131_OPT_TERMINATED)) {
+    counters.dropped++;
+    return 0;
+  }
+
+  uint16_t universe = be16(&hdr[113]) - firstUniverse;
+  if (universe >= universes) {
+    counters.dropped++; // Not one of ours
+    return 0;
+  }
+
+  if (lastSeq) {
+    // E1.31 6.7.2: out of order if 'behind' by less than 20
+    int8_t diff = (int8_t)(hdr[111] - lastSeq[universe]);
+    if ((seen[universe] & SEEN_SEQ) && (diff <= 0) && (diff > -20)) {
+      counters.dropped++;
+      return 0;
+    }
+    lastSeq[universe] = hdr[111];
+
+    // A repeat before the frame completed means packets went missing;
+    // start over rather than waiting on a frame that won't finish.
+    if (seen[universe] & SEEN_FRAME) {
+      for (uint16_t u = 0; u < universes; u++)
+        seen[u] &= ~SEEN_FRAME;
+      seenCount = 0;
+    }
+    seen[universe] |= SEEN_FRAME | SEEN_SEQ;
+    seenCount++;
+  }
+
+  syncAddress = be16(&hdr[109]);
+  p.headerLen = E131_HEADER_LEN;
+  p.universe = universe;
+  p.channel = (uint32_t)universe * universeChannels;
+  p.length = be16(&hdr[123]) - 1;
+  if (p.length > universeChannels)
+    p.length = universeChannels;
+  p.push = !syncAddress && lastSeq && (seenCount >= universes);
+  counters.packets++;
+  return 1;
+}
+
+void IRM_NetSink::applyChannels(uint32_t channel, const uint8_t *data,
+                                uint16_t len) {
+  // Only whole pixels are applied
+  uint8_t skip = (3 - channel % 3) % 3;
+  if (skip >= len)
+    return;
+  data += skip;
+  len -= skip;
+  channel += skip;
+
+  uint32_t led = channel / 3;
+  uint16_t total = matrix.numPixels(), count = len / 3;
+  if (led >= total)
+    return;
+  if (led + count > total)
+    count = total - led;
+
+  if ((mapping == IRM_NET_RAW) && matrix.isRawRGB()) {
+    memcpy(matrix.getPixels() + led * 3, data, count * 3);
+  } else {
+    int16_t w = matrix.width();
+    for (uint16_t i = 0; i < count; i++, led++, data += 3) {
+      uint16_t n = (mapping == IRM_NET_RAW) ? led
+                                            : matrix.mapXY(led % w, led / w);
+      matrix.setPixelColor(n, data[0], data[1], data[2]);
+    }
+  }
+  counters.pixels += count;
+}
+
+bool IRM_NetSink::finish(const Packet &p) {
+  if (!p.push)
+    return false;
+  if (seen) {
+    for (uint16_t u = 0; u < universes; u++)
+      seen[u] &= ~SEEN_FRAME;
+    seenCount = 0;
+  }
+  matrix.markAllDirty();
+  matrix.show();
+  counters.frames++;
+  return true;
+}
+
+bool IRM_NetSink::handlePacket(const uint8_t *data, size_t len) {
+  if (!matrix.getPixels()) { // Framebuffer mode: no LED buffer to write
+    counters.dropped++;
+    return false;
+  }
+  Packet p;
+  if (parseHeader(data, len, p) <= 0)
+    return false;
+  if (p.headerLen + p.length > len)
+    p.length = len - p.headerLen;
+  applyChannels(p.channel, data + p.headerLen, p.length);
+  return finish(p);
+}
+
+#ifdef ARDUINO
+bool IRM_NetSink::poll(UDP &udp) {
+  int size = udp.parsePacket();
+  if (size <= 0)
+    return false;
+  if (!matrix.getPixels()) { // Framebuffer mode: no LED buffer to write
+    udp.flush();
+    counters.dropped++;
+    return false;
+  }
+
+  // Read just the header; the payload goes straight to the LED buffer
+  uint8_t hdr[E131_HEADER_LEN];
+  int got = udp.read(hdr, 10);
+  if (got == 10) {
+    int want = 10;
+    if (hdr[0] == 0x00) // E1.31 root layer preamble
+      want = min(size, E131_HEADER_LEN);
+    else if (hdr[0] & DDP_FLAG_TIMECODE)
+      want = 14;
+    if (want > 10)
+      got += udp.read(&hdr[10], want - 10);
+  }
+
+  Packet p;
+  if ((got < 10) || (parseHeader(hdr, got, p) <= 0)) {
+    udp.flush();
+    return false;
+  }
+
+  uint16_t len = p.length;
+  if (size - p.headerLen < len)
+    len = size - p.headerLen;
+  uint32_t led = p.channel / 3;
+  if ((mapping == IRM_NET_RAW) && matrix.isRawRGB() && !(p.channel % 3) &&
+      (led < matrix.numPixels())) {
+    uint16_t count = min((uint32_t)len / 3, matrix.numPixels() - led);
+    udp.read(matrix.getPixels() + led * 3, count * 3);
+    counters.pixels += count;
+  } else {
+    uint8_t chunk[48]; // Whole pixels, so chunks stay aligned
+    uint32_t channel = p.channel;
+    uint8_t skip = (3 - channel % 3) % 3;
+    if (skip && (skip <= len)) { // Partial leading pixel isn't applied
+      udp.read(chunk, skip);
+      channel += skip;
+      len -= skip;
+    }
+    while (len) {
+      int n = udp.read(chunk, min(len, (uint16_t)sizeof(chunk)));
+      if (n <= 0)
+        break;
+      applyChannels(channel, chunk, n);
+      channel += n;
+      len -= n;
+    }
+  }
+  udp.flush();
+  return finish(p);
+}
+#endif
@@ -0,0 +1,129 @@
+/*!
+ * @file irm_netsink.h
+ *
+ * Network frame ingest for IRM_Mini: DDP and E1.31 (sACN) pixel data
+ * written straight into the LED buffer, so a central media server can
+ * drive the display.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_NETSINK__
+#define __IRM_NETSINK__
+
+#include "irm_mini.h"
+#ifdef ARDUINO
+#include <Udp.h>
+#endif
+
+#define IRM_NET_RAW 0 ///< Channel data in LED chain order
+#define IRM_NET_XY 1  ///< Channel data in display order, row by row
+
+#define IRM_DDP_PORT 4048  ///< Standard DDP UDP port
+#define IRM_E131_PORT 5568 ///< Standard E1.31 UDP port
+
+/**
+ * @brief Receiver counters, see IRM_NetSink::stats(). Sample them over
+ *        time for packets and pixels per second.
+ */
+struct IRM_NetStats {
+  uint32_t packets; ///< Packets accepted
+  uint32_t pixels;  ///< Pixels written
+  uint32_t frames;  ///< Frames shown
+  uint32_t dropped; ///< Late/out-of-order/preview packets, or no LED buffer
+  uint32_t errors;  ///< Malformed or unsupported packets
+};
+
+/**
+ * @brief DDP / E1.31 receiver. The parser works on plain byte buffers so
+ *        it runs the same on any platform; poll() adds the Arduino UDP
+ *        glue. A frame is shown on the DDP push flag, on an E1.31 sync
+ *        packet, or (E1.31 without sync) once every universe covering the
+ *        display has arrived.
+ */
+class IRM_NetSink {
+public:
+  /**
+   * @brief  Bind a receiver to a matrix.
+   * @param  matrix  Matrix to write into.
+   */
+  IRM_NetSink(IRM_Mini &matrix);
+
+  /**
+   * @brief  Allocate per-universe sequence state (from
+   *         matrix.allocBuffer()). Call after setUniverses().
+   * @return false if memory ran out; packets are still accepted, but
+   *         without E1.31 sequence checks or frame completion.
+   */
+  bool begin(void);
+
+  /**
+   * @brief  Choose how channel data maps onto the display.
+   * @param  mode  IRM_NET_RAW (chain order) or IRM_NET_XY (display order).
+   */
+  void setMapping(uint8_t mode) { mapping = mode; }
+
+  /**
+   * @brief  E1.31 universe layout.
+   * @param  first     Universe holding the first pixel.
+   * @param  channels  Channels used per universe (510 = 170 RGB pixels),
+   *                   3 to 512.
+   * @return false if channels is out of range; nothing changes.
+   */
+  bool setUniverses(uint16_t first, uint16_t channels = 510);
+
+  /**
+   * @brief  Parse one UDP payload (DDP or E1.31) and apply it.
+   * @param  data  Packet bytes.
+   * @param  len   Packet length.
+   * @return true if the packet completed a frame and show() was called.
+   */
+  bool handlePacket(const uint8_t *data, size_t len);
+
+#ifdef ARDUINO
+  /**
+   * @brief  Receive and apply one packet, if any. Headers are read into a
+   *         small buffer; pixel data is read from the socket straight into
+   *         the LED buffer when isRawRGB() allows, else in small chunks.
+   * @param  udp  Socket bound to IRM_DDP_PORT or IRM_E131_PORT.
+   * @return true if a frame was shown.
+   */
+  bool poll(UDP &udp);
+#endif
+
+  /**
+   * @brief  Receiver counters.
+   * @return Counters since construction.
+   */
+  const IRM_NetStats &stats(void) const { return counters; }
+
+private:
+  // What a header said, before the payload is applied
+  struct Packet {
+    uint8_t headerLen;  // Bytes before pixel data
+    uint32_t channel;   // First channel of the payload, display-wide
+    uint16_t length;    // Payload bytes
+    bool push;          // Frame complete after this packet
+    bool sync;          // E1.31 sync packet (no payload)
+    uint16_t universe;  // E1.31 universe slot (index from first), or 0xFFFF
+  };
+
+  int8_t parseHeader(const uint8_t *hdr, size_t len, Packet &p);
+  void applyChannels(uint32_t channel, const uint8_t *data, uint16_t len);
+  bool finish(const Packet &p);
+
+  IRM_Mini &matrix;
+  uint8_t mapping = IRM_NET_RAW;
+  uint16_t firstUniverse = 1, universeChannels = 510, universes = 0;
+  uint8_t *lastSeq = NULL;  // Per universe E1.31 sequence numbers
+  uint16_t seqUniverses = 0; // Universes lastSeq has room for
+  uint8_t *seen = NULL;     // Per universe 'arrived this frame' flags
+  uint16_t seenCount = 0;
+  uint8_t ddpSeq = 0;       // Last DDP sequence number, 0 = none yet
+  uint16_t syncAddress = 0; // E1.31 sync universe in use, 0 = none
+  IRM_NetStats counters = {};
+};
+
+#endif // __IRM_NETSINK__
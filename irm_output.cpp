@@ -0,0 +1,110 @@
+/*!
+ * @file irm_output.cpp
+ *
+ * Output backends for IRM_Mini, see irm_output.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_output.h"
+#if defined(__linux__)
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+// The NeoPixel half owns no buffer: it transmits from the caller's frame
+IRM_NeoPixelOutput::IRM_NeoPixelOutput(int16_t p, neoPixelType t)
+    : Adafruit_NeoPixel() {
+  updateType(t);
+  setPin(p);
+  chunkOK = false;
+}
+
+IRM_NeoPixelOutput::~IRM_NeoPixelOutput() {
+  if (wireOwner)
+    wireOwner->freeBuffer(wire);
+  pixels = NULL;
+}
+
+bool IRM_NeoPixelOutput::begin(const IRM_PixelFormat &format,
+                               uint16_t numLEDs) {
+  IRM_Output::begin(format, numLEDs);
+  if (wireOwner)
+    wireOwner->freeBuffer(wire);
+  wire = NULL;
+  wireOwner = NULL;
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  bool same = (bpp == fmt.bpp) && (rOffset == fmt.r) && (gOffset == fmt.g) &&
+              (bOffset == fmt.b) && ((bpp == 3) || (wOffset == fmt.w));
+  if (!same) {
+    // From the matrix, so an arena given to IRM_Mini::begin() holds it
+    if (!matrix || !(wire = (uint8_t *)matrix->allocBuffer(numLEDs * bpp)))
+      return false;
+    wireOwner = matrix;
+  }
+  Adafruit_NeoPixel::begin();
+  return true;
+}
+
+void IRM_NeoPixelOutput::write(const uint8_t *data, uint16_t count) {
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  if (count > leds)
+    count = leds;
+  if (wire) {
+    const uint8_t *src = data;
+    uint8_t *dst = wire;
+    for (uint16_t i = 0; i < count; i++, src += fmt.bpp, dst += bpp) {
+      dst[rOffset] = src[fmt.r];
+      dst[gOffset] = src[fmt.g];
+      dst[bOffset] = src[fmt.b];
+      if (bpp == 4)
+        dst[wOffset] = (fmt.bpp == 4) ? src[fmt.w] : 0;
+    }
+    data = wire;
+  }
+  pixels = (uint8_t *)data;
+  numLEDs = count;
+  numBytes = count * bpp;
+  Adafruit_NeoPixel::show();
+  pixels = NULL;
+}
+
+IRM_MemoryOutput::IRM_MemoryOutput(uint8_t *b, uint16_t n)
+    : buf(b), maxLEDs(n) {}
+
+void IRM_MemoryOutput::beginFrame(uint16_t count) {
+  (void)count;
+  pos = 0;
+}
+
+void IRM_MemoryOutput::write(const uint8_t *data, uint16_t count) {
+  if (count > maxLEDs - pos)
+    count = maxLEDs - pos;
+  toRGB(data, &buf[pos * fmt.bpp], count, fmt.bpp == 4);
+  pos += count;
+}
+
+#if defined(__linux__)
+// Converted a chunk at a time, so there's no frame-sized buffer
+void IRM_FileOutput::write(const uint8_t *data, uint16_t count) {
+  uint8_t chunk[64 * 3];
+  while (count) {
+    uint16_t n = (count < 64) ? count : 64;
+    toRGB(data, chunk, n);
+    for (size_t off = 0; off < n * 3u;) {
+      ssize_t r = ::write(fd, chunk + off, n * 3 - off);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0) {
+        failed++;
+        return;
+      }
+      off += r;
+    }
+    data += n * fmt.bpp;
+    count -= n;
+  }
+}
+#endif
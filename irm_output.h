@@ -0,0 +1,110 @@
+/*!
+ * @file irm_output.h
+ *
+ * Output backends for IRM_Mini::setOutput(): a NeoPixel chain on any pin
+ * and color order, a memory sink, and (on Linux host builds) a file or
+ * socket sink for simulators. The APA102/SK9822 SPI backend is in
+ * irm_apa102.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_OUTPUT__
+#define __IRM_OUTPUT__
+
+#include "irm_mini.h"
+
+/**
+ * @brief WS2812/SK6812 chain on a pin of its own. If its color order
+ *        matches the LED buffer, frames are sent straight from the buffer;
+ *        otherwise they are converted into a buffer of its own first.
+ *        Each frame must come in a single write() (chunkedWrites() is
+ *        false), so a framebuffer mode keeps the LED buffer for it.
+ */
+class IRM_NeoPixelOutput : public IRM_Output, protected Adafruit_NeoPixel {
+public:
+  /**
+   * @brief  Describe the chain.
+   * @param  pin   Data pin.
+   * @param  type  LED type, as for Adafruit_NeoPixel (e.g. NEO_GRB +
+   *               NEO_KHZ800).
+   */
+  IRM_NeoPixelOutput(int16_t pin, neoPixelType type = NEO_GRB + NEO_KHZ800);
+  ~IRM_NeoPixelOutput();
+
+  bool begin(const IRM_PixelFormat &format, uint16_t numLEDs);
+  void write(const uint8_t *data, uint16_t count);
+
+private:
+  uint8_t *wire = NULL; // Converted frame, when the color orders differ
+  IRM_Mini *wireOwner = NULL; // Matrix wire was allocated from
+};
+
+/**
+ * @brief Keeps the last frame in memory as plain R, G, B bytes (plus W
+ *        for RGBW buffers), e.g. to compare frames in tests or hand them
+ *        to other code.
+ */
+class IRM_MemoryOutput : public IRM_Output {
+public:
+  /**
+   * @brief  Use a caller's buffer.
+   * @param  buf      Receives 3 (RGBW: 4) bytes per LED.
+   * @param  maxLEDs  LEDs buf can hold; the rest of a frame is dropped.
+   */
+  IRM_MemoryOutput(uint8_t *buf, uint16_t maxLEDs);
+
+  /**
+   * @brief  Frames completed.
+   * @return Frame count.
+   */
+  uint32_t frames(void) const { return done; }
+
+  /**
+   * @brief  LEDs in the last frame.
+   * @return LED count.
+   */
+  uint16_t frameLEDs(void) const { return pos; }
+
+  void beginFrame(uint16_t count);
+  void write(const uint8_t *data, uint16_t count);
+  void endFrame(void) { done++; }
+
+private:
+  uint8_t *buf;
+  uint16_t maxLEDs, pos = 0;
+  uint32_t done = 0;
+};
+
+#if defined(__linux__)
+/**
+ * @brief Linux simulator output: each frame is written to a file
+ *        descriptor (file, pipe or connected socket) as count * 3 bytes of
+ *        R, G, B in chain order, e.g. for
+ *        ffplay -f rawvideo -pixel_format rgb24 -video_size 256x1 -.
+ */
+class IRM_FileOutput : public IRM_Output {
+public:
+  /**
+   * @brief  Write to a descriptor; it is not closed.
+   * @param  fd  Open descriptor.
+   */
+  IRM_FileOutput(int fd) : fd(fd) {}
+
+  /**
+   * @brief  Frames that couldn't be written completely.
+   * @return Error count.
+   */
+  uint32_t errors(void) const { return failed; }
+
+  void write(const uint8_t *data, uint16_t count);
+
+private:
+  int fd;
+  uint32_t failed = 0;
+};
+#endif
+
+#endif // __IRM_OUTPUT__
@@ -0,0 +1,168 @@
+/*!
+ * @file irm_pipeline.cpp
+ *
+ * Render/transmit pipeline for IRM_Mini, see irm_pipeline.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_pipeline.h"
+
+IRM_Pipeline::IRM_Pipeline(IRM_Mini &m) : Adafruit_NeoPixel(), matrix(m) {}
+
+bool IRM_Pipeline::begin(uint8_t frames, int8_t outputCore) {
+#if IRM_HAS_THREADS
+  if (running || (frames < 2) || !matrix.pixels || matrix.fb)
+    return false;
+
+  frameBytes = matrix.numBytes;
+  size_t need = (size_t)frames * frameBytes;
+  if (slots && (need > slotBytes)) { // Ring grew since the last begin()
+    matrix.freeBuffer(slots);
+    slots = NULL;
+  }
+  if (!slots) {
+    if (!(slots = (uint8_t *)matrix.allocBuffer(need)))
+      return false;
+    slotBytes = need;
+  }
+  ring.begin(slots, frames, frameBytes);
+
+  // The NeoPixel half of this object transmits from ring slots, so it
+  // mirrors the matrix's pin and wire format but owns no buffer.
+  pin = matrix.pin;
+  numLEDs = matrix.numLEDs;
+  numBytes = matrix.numBytes;
+  rOffset = matrix.rOffset;
+  gOffset = matrix.gOffset;
+  bOffset = matrix.bOffset;
+  wOffset = matrix.wOffset;
+#ifdef NEO_KHZ400
+  is800KHz = matrix.is800KHz;
+#endif
+  begun = true;
+
+  // Render into the ring from now on, starting from the current frame
+  ownBuf = matrix.pixels;
+  memcpy(ring.producerSlot(), ownBuf, frameBytes);
+  matrix.pixels = ring.producerSlot();
+  matrix.pipeline = this;
+
+  running = true;
+  IRM_ADD(tasks, 1);
+  if (!irmStartTask(outputTask, this, "irm_output", outputCore)) {
+    IRM_ADD(tasks, -1);
+    end();
+    return false;
+  }
+  return true;
+#else
+  (void)frames;
+  (void)outputCore;
+  return false;
+#endif
+}
+
+bool IRM_Pipeline::startRenderTask(int8_t core) {
+#if IRM_HAS_THREADS
+  if (!running)
+    return false;
+  IRM_ADD(tasks, 1);
+  if (!irmStartTask(renderTask, this, "irm_render", core)) {
+    IRM_ADD(tasks, -1);
+    return false;
+  }
+  return true;
+#else
+  (void)core;
+  return false;
+#endif
+}
+
+void IRM_Pipeline::end(void) {
+#if IRM_HAS_THREADS
+  if (!matrix.pipeline)
+    return;
+  running = false;
+  while (IRM_LOAD(tasks))
+    irmSleep();
+  memcpy(ownBuf, matrix.pixels, frameBytes);
+  matrix.pixels = ownBuf;
+  matrix.pipeline = NULL;
+  // Unbind the NeoPixel half from the matrix's pin, or ~Adafruit_NeoPixel()
+  // would let go of it (pinMode(INPUT), and the RMT channel on ESP32) and
+  // leave the matrix unable to show()
+  pixels = NULL;
+  pin = -1;
+  numLEDs = numBytes = 0;
+  begun = false;
+  matrix.freeBuffer(slots);
+  slots = NULL;
+  slotBytes = 0;
+#endif
+}
+
+void IRM_Pipeline::publish(void) {
+#if IRM_HAS_THREADS
+  uint8_t *done = ring.producerSlot();
+  while (!ring.canPublish()) { // Output is behind; wait for a free slot
+    if (!running)
+      return;
+    stalls = stalls + 1;
+    irmSleep();
+  }
+  // Copy before publishing: once published, the output task may
+  // calibrate done in place
+  memcpy(ring.nextSlot(), done, frameBytes);
+  ring.publish();
+  matrix.pixels = ring.producerSlot();
+#endif
+}
+
+void IRM_Pipeline::transmit(uint8_t *frame) {
+  if (matrix.output) {
+    matrix.output->send(frame, matrix.numLEDs);
+    return;
+  }
+  pixels = frame;
+  Adafruit_NeoPixel::show();
+  pixels = NULL;
+}
+
+void IRM_Pipeline::outputTask(void *arg) {
+#if IRM_HAS_THREADS
+  IRM_Pipeline *p = (IRM_Pipeline *)arg;
+  while (p->running) {
+    uint8_t *frame = p->ring.consumerSlot();
+    if (!frame) {
+      irmSleep();
+      continue;
+    }
+    if (p->matrix.calGains) // publish() copied it out before handing over
+      p->matrix.calibrate(frame, frame, p->matrix.numLEDs);
+    p->transmit(frame);
+    p->ring.release();
+    p->sent = p->sent + 1;
+  }
+  IRM_ADD(p->tasks, -1);
+  irmEndTask();
+#else
+  (void)arg;
+#endif
+}
+
+void IRM_Pipeline::renderTask(void *arg) {
+#if IRM_HAS_THREADS
+  IRM_Pipeline *p = (IRM_Pipeline *)arg;
+  while (p->running) {
+    if (!p->matrix.tick(millis()))
+      irmSleep();
+  }
+  IRM_ADD(p->tasks, -1);
+  irmEndTask();
+#else
+  (void)arg;
+#endif
+}
@@ -0,0 +1,103 @@
+/*!
+ * @file irm_pipeline.h
+ *
+ * Optional pipelined output for IRM_Mini: frame N+1 is rendered while
+ * frame N is transmitted, with rendering and output on separate tasks
+ * (pinned to separate cores on ESP32).
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_PIPELINE__
+#define __IRM_PIPELINE__
+
+#include "irm_mini.h"
+#include "irm_ring.h"
+
+/**
+ * @brief Render/transmit pipeline. Once begin() succeeds, the matrix draws
+ *        into ring slots and show() just publishes the finished frame; an
+ *        output task transmits queued frames. Each new frame starts as a
+ *        copy of the previous one, so incremental drawing keeps working.
+ *        Partial show() is bypassed while the pipeline runs.
+ */
+class IRM_Pipeline : protected Adafruit_NeoPixel {
+public:
+  /**
+   * @brief  Bind a pipeline to a matrix.
+   * @param  matrix  Matrix to pipeline; begin() it first.
+   */
+  IRM_Pipeline(IRM_Mini &matrix);
+  virtual ~IRM_Pipeline() { end(); }
+
+  /**
+   * @brief  Allocate the frame ring (with matrix.allocBuffer()) and start
+   *         the output task.
+   * @param  frames      Ring slots: one being drawn, one being sent, the
+   *                     rest queued. At least 2.
+   * @param  outputCore  Core for the output task, -1 for any.
+   * @return false if threads aren't available on this board, memory
+   *         ran out or the matrix is in a framebuffer mode.
+   */
+  bool begin(uint8_t frames = 3, int8_t outputCore = 0);
+
+  /**
+   * @brief  Also move rendering off loop(): start a task that drives
+   *         matrix.tick(millis()), leaving loop() to networking.
+   * @param  core  Core for the render task, -1 for any.
+   * @return true if the task was started.
+   */
+  bool startRenderTask(int8_t core = 1);
+
+  /**
+   * @brief  Stop both tasks, hand the matrix back its own LED buffer,
+   *         holding the last rendered frame, and release the ring. The
+   *         pipeline stops driving the matrix's pin, so destroying it
+   *         leaves the matrix's output alone.
+   */
+  void end(void);
+
+  /**
+   * @brief  Frames transmitted by the output task.
+   * @return Frame count.
+   */
+  uint32_t framesSent(void) const { return sent; }
+
+  /**
+   * @brief  Times show() had to wait for a free slot (output slower than
+   *         rendering).
+   * @return Stall count.
+   */
+  uint32_t renderStalls(void) const { return stalls; }
+
+protected:
+  /**
+   * @brief  Send one frame; runs on the output task. The default sends
+   *         the ring slot to the matrix's output (IRM_Mini::setOutput()),
+   *         or drives its NeoPixel pin straight from the slot.
+   * @param  frame  LED data in the matrix's wire format.
+   */
+  virtual void transmit(uint8_t *frame);
+
+  IRM_Mini &matrix; ///< Matrix being pipelined
+
+private:
+  friend class IRM_Mini;
+  void publish(void); // IRM_Mini::show() in pipeline mode
+
+  static void outputTask(void *arg);
+  static void renderTask(void *arg);
+
+  IRM_FrameRing ring;
+  uint8_t *slots = NULL;   // Ring memory
+  size_t slotBytes = 0;    // Size of slots
+  uint8_t *ownBuf = NULL;  // Matrix's own LED buffer while pipelined
+  uint16_t frameBytes = 0;
+  volatile bool running = false;
+  uint8_t tasks = 0;       // Live tasks, via IRM_LOAD/IRM_STORE
+  volatile uint32_t sent = 0, stalls = 0;
+};
+
+#endif // __IRM_PIPELINE__
@@ -0,0 +1,118 @@
+/*!
+ * @file irm_port.h
+ *
+ * Thin portability layer for the IRM_Mini render/transmit pipeline:
+ * tasks on FreeRTOS (ESP32) or std::thread (Linux host builds), plus the
+ * atomic load/store used by the lock-free frame ring. Boards without
+ * threads get IRM_HAS_THREADS = 0 and the pipeline stays disabled.
+ * Also memory that survives deep sleep, for IRM_Mini snapshots.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_PORT__
+#define __IRM_PORT__
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define IRM_HAS_THREADS 1
+#elif defined(__linux__)
+#include <chrono>
+#include <thread>
+#define IRM_HAS_THREADS 1
+#else
+#define IRM_HAS_THREADS 0
+#endif
+
+// Places a variable in memory that keeps its contents through deep sleep
+// (and, where the platform allows, resets) and isn't zeroed at boot
+#if defined(ESP32)
+#define IRM_RETAINED RTC_NOINIT_ATTR
+#elif defined(__AVR__)
+#define IRM_RETAINED __attribute__((section(".noinit")))
+#else
+#define IRM_RETAINED
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief  Host stand-in for retained memory: a region mapped from a file,
+ *         so it outlives the process the way RTC memory outlives deep
+ *         sleep. Run a simulator twice and the second run starts from the
+ *         first one's snapshot. A new file starts zeroed (no snapshot).
+ * @param  path  Backing file, created if needed.
+ * @param  size  Region size in bytes.
+ * @return Region, or NULL if the file can't be mapped.
+ */
+static inline void *irmRetainedMemory(const char *path, size_t size) {
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    return NULL;
+  void *p = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  return (p == MAP_FAILED) ? NULL : p;
+}
+#endif
+
+// Single-producer/single-consumer handoff only needs acquire/release
+// ordering on the ring indices; GCC provides these on every target.
+#define IRM_LOAD(v) __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define IRM_STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+#define IRM_ADD(v, x) __atomic_add_fetch(&(v), (x), __ATOMIC_ACQ_REL)
+
+#if IRM_HAS_THREADS
+
+/**
+ * @brief  Start a task, pinned to a core where the platform allows it.
+ * @param  fn    Task body.
+ * @param  arg   Passed to fn.
+ * @param  name  Task name (FreeRTOS only).
+ * @param  core  Core to pin to, -1 for any.
+ * @return true if the task was started.
+ */
+static inline bool irmStartTask(void (*fn)(void *), void *arg,
+                                const char *name, int8_t core) {
+#if defined(ESP32)
+  return xTaskCreatePinnedToCore(fn, name, 4096, arg, 1, NULL,
+                                 (core < 0) ? tskNO_AFFINITY : core) ==
+         pdPASS;
+#else
+  (void)name;
+  (void)core; // Host builds leave placement to the OS scheduler
+  std::thread(fn, arg).detach();
+  return true;
+#endif
+}
+
+/**
+ * @brief  Give up the CPU briefly while waiting on the other task.
+ */
+static inline void irmSleep(void) {
+#if defined(ESP32)
+  vTaskDelay(1);
+#else
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+#endif
+}
+
+/**
+ * @brief  End the calling task (after irmStartTask()).
+ */
+static inline void irmEndTask(void) {
+#if defined(ESP32)
+  vTaskDelete(NULL);
+#endif
+}
+
+#endif // IRM_HAS_THREADS
+
+#endif // __IRM_PORT__
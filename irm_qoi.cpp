@@ -0,0 +1,223 @@
+/*!
+ * @file irm_qoi.cpp
+ *
+ * Streaming QOI decoder for IRM_Mini, see irm_qoi.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_qoi.h"
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+
+static const char qoiMagic[] = "qoif";
+
+IRM_QoiDecoder::IRM_QoiDecoder(IRM_Mini &matrix) : matrix(matrix) {}
+
+void IRM_QoiDecoder::begin(int16_t x, int16_t y) {
+  left = x;
+  top = y;
+  state = QOI_HEADER;
+  part = 0;
+  imgW = imgH = 0;
+  col = row = 0;
+  queued = 0;
+  memset(index, 0, sizeof(index));
+  px[0] = px[1] = px[2] = 0;
+  px[3] = 255;
+}
+
+// 14 bytes: "qoif", width and height (32-bit big-endian), channels and
+// colorspace. The last two don't matter here: every op carries RGBA.
+void IRM_QoiDecoder::header(uint8_t b) {
+  if (part < 4) {
+    if (b != (uint8_t)qoiMagic[part])
+      state = QOI_ERROR;
+  } else if (part < 12) {
+    header32 = (header32 << 8) | b;
+    if ((part == 7) || (part == 11)) {
+      if (!header32 || (header32 > 32767)) {
+        state = QOI_ERROR;
+        return;
+      }
+      if (part == 7)
+        imgW = header32;
+      else
+        imgH = header32;
+    }
+  } else if (part == 13) {
+    int16_t x0 = (left < 0) ? -left : 0, x1 = matrix.width() - left;
+    visL = (x0 < imgW) ? x0 : imgW;
+    visR = (x1 < visL) ? visL : (x1 < imgW) ? x1 : imgW;
+    state = QOI_OP;
+    return;
+  }
+  part++;
+}
+
+// Draw the queued pixels, a run of one row
+void IRM_QoiDecoder::flush(void) {
+  if (queued) {
+    matrix.drawRow(left + queueX, top + row, queue, queued);
+    queued = 0;
+  }
+}
+
+// Emit n pixels of the current color, wrapping rows as QOI runs do. Only
+// the on-screen part of each row is queued.
+void IRM_QoiDecoder::put(uint8_t n) {
+  memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63], px, 4);
+  color = ((px[0] & 0xF8) << 8) | ((px[1] & 0xFC) << 3) | (px[2] >> 3);
+  int16_t y = top + row;
+  while (n) {
+    uint16_t k = min((uint16_t)n, (uint16_t)(imgW - col));
+    if ((px[3] >= 128) && (y >= 0) && (y < matrix.height())) {
+      uint16_t a = max(col, visL), b = min((uint16_t)(col + k), visR);
+      if (a < b) {
+        if (queued && (queueX + queued != a))
+          flush();
+        if (!queued)
+          queueX = a;
+        for (; a < b; a++) {
+          queue[queued++] = color;
+          if (queued == IRM_QOI_CHUNK) {
+            flush();
+            queueX = a + 1;
+          }
+        }
+      }
+    }
+    col += k;
+    n -= k;
+    if (col == imgW) {
+      flush();
+      col = 0;
+      if (++row == imgH) {
+        state = QOI_PAD;
+        part = 0;
+        return;
+      }
+      y++;
+    }
+  }
+}
+
+bool IRM_QoiDecoder::feed(uint8_t b) {
+  switch (state) {
+  case QOI_HEADER:
+    header(b);
+    return false;
+
+  case QOI_OP:
+    if (b >= QOI_OP_RGB) {
+      op = b;
+      need = (b == QOI_OP_RGB) ? 3 : 4;
+      part = 0;
+      state = QOI_ARGS;
+      return false;
+    }
+    switch (b & 0xC0) {
+    case QOI_OP_INDEX:
+      memcpy(px, index[b], 4);
+      put(1);
+      break;
+    case QOI_OP_DIFF:
+      px[0] += ((b >> 4) & 3) - 2;
+      px[1] += ((b >> 2) & 3) - 2;
+      px[2] += (b & 3) - 2;
+      put(1);
+      break;
+    case QOI_OP_LUMA:
+      op = b;
+      need = 1;
+      part = 0;
+      state = QOI_ARGS;
+      break;
+    default: // QOI_OP_RUN
+      put((b & 0x3F) + 1);
+    }
+    return false;
+
+  case QOI_ARGS:
+    args[part++] = b;
+    if (part < need)
+      return false;
+    state = QOI_OP;
+    if ((op & 0xC0) == QOI_OP_LUMA) {
+      int8_t dg = (op & 0x3F) - 32;
+      px[0] += dg - 8 + (b >> 4);
+      px[1] += dg;
+      px[2] += dg - 8 + (b & 0x0F);
+    } else {
+      memcpy(px, args, need);
+    }
+    put(1);
+    return false;
+
+  case QOI_PAD:
+    // Seven 0x00 and a 0x01 close the stream; the pixels are all drawn
+    // already, so they're only counted
+    if (++part == 8) {
+      state = QOI_DONE;
+      return true;
+    }
+    return false;
+
+  default: // QOI_DONE, QOI_ERROR
+    return false;
+  }
+}
+
+bool IRM_QoiDecoder::poll(Stream &s) {
+  while ((state != QOI_DONE) && (state != QOI_ERROR) && (s.available() > 0)) {
+    int c = s.read();
+    if (c < 0)
+      break;
+    feed(c);
+  }
+  return state == QOI_DONE;
+}
+
+bool IRM_QoiDecoder::draw(int16_t x, int16_t y, const uint8_t *data,
+                          size_t len, bool progmem) {
+  begin(x, y);
+  for (size_t i = 0; (i < len) && (state < QOI_DONE); i++)
+    feed(progmem ? pgm_read_byte(&data[i]) : data[i]);
+  return state == QOI_DONE;
+}
+
+bool IRM_QoiDecoder::draw(int16_t x, int16_t y, Stream &s) {
+  begin(x, y);
+  uint8_t buf[32];
+  while (state < QOI_DONE) {
+    // Read no more than the image must still have left, so nothing after
+    // it is consumed: an op byte yields at most 62 pixels
+    uint32_t want;
+    if (state == QOI_HEADER) {
+      want = 14 - part;
+    } else if (state == QOI_PAD) {
+      want = 8 - part;
+    } else {
+      uint32_t pixels = (uint32_t)(imgH - row) * imgW - col;
+      want = 8;
+      if (state == QOI_ARGS) {
+        want += need - part; // The pending op's pixel is one of pixels
+        pixels--;
+      }
+      want += (pixels + 61) / 62;
+    }
+    size_t n = s.readBytes(buf, min(want, (uint32_t)sizeof(buf)));
+    if (!n)
+      break;
+    for (size_t i = 0; i < n; i++)
+      feed(buf[i]);
+  }
+  return state == QOI_DONE;
+}
@@ -0,0 +1,97 @@
+/*!
+ * @file irm_ring.h
+ *
+ * Lock-free single-producer/single-consumer ring of LED frame buffers,
+ * used by IRM_Pipeline to hand finished frames from the render task to
+ * the output task.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_RING__
+#define __IRM_RING__
+
+#include "irm_port.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Ring of equally sized frame slots. The producer always owns the
+ *        slot at head; frames from tail up to head are queued, and the
+ *        consumer keeps the slot at tail until release().
+ */
+class IRM_FrameRing {
+public:
+  /**
+   * @brief  Attach slot memory.
+   * @param  mem        slots * slotBytes bytes.
+   * @param  slots      Number of slots, 2 or more.
+   * @param  slotBytes  Size of one frame.
+   */
+  void begin(uint8_t *mem, uint8_t slots, size_t slotBytes) {
+    buf = mem;
+    n = slots;
+    size = slotBytes;
+    head = tail = 0;
+  }
+
+  /**
+   * @brief  Slot the producer is currently filling.
+   * @return Pointer to slotBytes bytes.
+   */
+  uint8_t *producerSlot(void) const { return &buf[head * size]; }
+
+  /**
+   * @brief  Slot the producer moves on to at publish(). Only valid while
+   *         canPublish() is true; the consumer can't be using it then.
+   * @return Pointer to slotBytes bytes.
+   */
+  uint8_t *nextSlot(void) const { return &buf[((head + 1) % n) * size]; }
+
+  /**
+   * @brief  Check whether publish() can proceed without overtaking the
+   *         consumer.
+   * @return true if the next slot is free.
+   */
+  bool canPublish(void) const {
+    return (uint8_t)((head + 1) % n) != IRM_LOAD(tail);
+  }
+
+  /**
+   * @brief  Queue the producer's slot and move on to the next one.
+   *         Only call when canPublish() is true.
+   */
+  void publish(void) { IRM_STORE(head, (uint8_t)((head + 1) % n)); }
+
+  /**
+   * @brief  Oldest queued frame, kept by the consumer until release().
+   * @return Frame pointer, or NULL if nothing is queued.
+   */
+  uint8_t *consumerSlot(void) const {
+    return (tail == IRM_LOAD(head)) ? NULL : &buf[tail * size];
+  }
+
+  /**
+   * @brief  Hand the consumer's slot back to the producer.
+   */
+  void release(void) { IRM_STORE(tail, (uint8_t)((tail + 1) % n)); }
+
+  /**
+   * @brief  Frames waiting for the consumer.
+   * @return Queue depth.
+   */
+  uint8_t queued(void) const {
+    return (uint8_t)(IRM_LOAD(head) + n - IRM_LOAD(tail)) % n;
+  }
+
+private:
+  uint8_t *buf = NULL;
+  size_t size = 0;
+  uint8_t n = 0;
+  uint8_t head = 0; // Written by producer only
+  uint8_t tail = 0; // Written by consumer only
+};
+
+#endif // __IRM_RING__
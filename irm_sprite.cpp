@@ -0,0 +1,273 @@
+/*!
+ * @file irm_sprite.cpp
+ *
+ * Sprites for IRM_Mini, see irm_sprite.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_sprite.h"
+
+IRM_Sprite::IRM_Sprite(const void *bm, uint8_t fmt, uint8_t width,
+                       uint8_t height, const uint16_t *pal, bool pgm) {
+  setBitmap(bm, fmt, width, height, pal, pgm);
+}
+
+void IRM_Sprite::setBitmap(const void *bm, uint8_t fmt, uint8_t width,
+                           uint8_t height, const uint16_t *pal, bool pgm) {
+  bitmap = bm;
+  progmem = pgm;
+  format = fmt;
+  w = width;
+  h = height;
+  palette = pal;
+  changed = true;
+}
+
+void IRM_Sprite::setTransparent(uint32_t k) {
+  key = k;
+  hasKey = true;
+  changed = true;
+}
+
+void IRM_Sprite::setOpaque(void) {
+  hasKey = false;
+  changed = true;
+}
+
+void IRM_Sprite::moveTo(int16_t x, int16_t y) {
+  fx = (int32_t)x << 4;
+  fy = (int32_t)y << 4;
+  remX = remY = 0;
+}
+
+void IRM_Sprite::setVelocity(int16_t vx, int16_t vy) {
+  velX = vx;
+  velY = vy;
+}
+
+void IRM_Sprite::setZ(int8_t depth) {
+  if (depth != z) {
+    z = depth;
+    changed = true;
+  }
+}
+
+void IRM_Sprite::setVisible(bool on) {
+  if (on != visible) {
+    visible = on;
+    changed = true;
+  }
+}
+
+// Pixel (sx, sy) of the bitmap as RGB565; false if transparent
+bool IRM_Sprite::pixel(int16_t sx, int16_t sy, uint16_t &color) const {
+  uint16_t i = (uint16_t)sy * w + sx;
+  uint32_t v;
+  switch (format) {
+  case IRM_SPRITE_RGB888: {
+    const uint32_t *p = &((const uint32_t *)bitmap)[i];
+    v = progmem ? pgm_read_dword(p) : *p;
+    color = IRM_Mini::Color(v >> 16, v >> 8, v);
+    break;
+  }
+  case IRM_SPRITE_PAL8: {
+    const uint8_t *p = &((const uint8_t *)bitmap)[i];
+    v = progmem ? pgm_read_byte(p) : *p;
+    color = progmem ? pgm_read_word(&palette[v]) : palette[v];
+    break;
+  }
+  default: {
+    const uint16_t *p = &((const uint16_t *)bitmap)[i];
+    v = color = progmem ? pgm_read_word(p) : *p;
+    break;
+  }
+  }
+  return !hasKey || (v != key);
+}
+
+IRM_SpriteLayer::IRM_SpriteLayer(IRM_Mini &m) : matrix(m) {}
+
+IRM_SpriteLayer::~IRM_SpriteLayer() { matrix.freeBuffer(row); }
+
+void IRM_SpriteLayer::add(IRM_Sprite *s) {
+  IRM_Sprite **p = &sprites;
+  while (*p)
+    p = &(*p)->next;
+  *p = s;
+  s->next = NULL;
+  s->drawnW = s->drawnH = 0;
+  s->changed = true;
+}
+
+void IRM_SpriteLayer::remove(IRM_Sprite *s) {
+  for (IRM_Sprite **p = &sprites; *p; p = &(*p)->next) {
+    if (*p == s) {
+      *p = s->next;
+      s->next = NULL;
+      addRect(s->drawnX, s->drawnY, s->drawnW, s->drawnH);
+      s->drawnW = s->drawnH = 0;
+      return;
+    }
+  }
+}
+
+void IRM_SpriteLayer::setBackground(uint16_t color) {
+  bgBitmap = NULL;
+  bgColor = color;
+  full = true;
+}
+
+void IRM_SpriteLayer::setBackground(const uint16_t *bitmap, bool progmem) {
+  bgBitmap = bitmap;
+  bgProgmem = progmem;
+  full = true;
+}
+
+void IRM_SpriteLayer::update(uint32_t dt) {
+  if (dt > 1000)
+    dt = 1000; // Keep velocity * dt in range after a long stall
+  int16_t dw = matrix.width(), dh = matrix.height();
+
+  for (IRM_Sprite *s = sprites; s; s = s->next) {
+    // Velocities are 1/16 pixel per second, positions 1/16 pixel
+    int32_t mx = (int32_t)s->velX * dt + s->remX;
+    int32_t my = (int32_t)s->velY * dt + s->remY;
+    s->fx += mx / 1000;
+    s->fy += my / 1000;
+    s->remX = mx % 1000;
+    s->remY = my % 1000;
+    if (!s->bounce)
+      continue;
+
+    int32_t lo = (int32_t)min(0, dw - s->w) << 4;
+    int32_t hi = (int32_t)max(0, dw - s->w) << 4;
+    if ((s->fx < lo) || (s->fx > hi)) {
+      s->fx = (s->fx < lo) ? lo : hi;
+      s->velX = -s->velX;
+      s->remX = 0;
+    }
+    lo = (int32_t)min(0, dh - s->h) << 4;
+    hi = (int32_t)max(0, dh - s->h) << 4;
+    if ((s->fy < lo) || (s->fy > hi)) {
+      s->fy = (s->fy < lo) ? lo : hi;
+      s->velY = -s->velY;
+      s->remY = 0;
+    }
+  }
+}
+
+// Queue a rectangle for recomposing, clipped to the display and merged
+// with any queued rectangle it overlaps so no LED is written twice.
+void IRM_SpriteLayer::addRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  Rect r = {max(x, (int16_t)0), max(y, (int16_t)0),
+            min((int16_t)(x + w), matrix.width()),
+            min((int16_t)(y + h), matrix.height())};
+  if ((r.x0 >= r.x1) || (r.y0 >= r.y1))
+    return;
+
+  for (uint8_t i = 0; i < nRects;) {
+    Rect &q = rects[i];
+    if ((r.x0 < q.x1) && (q.x0 < r.x1) && (r.y0 < q.y1) && (q.y0 < r.y1)) {
+      r.x0 = min(r.x0, q.x0);
+      r.y0 = min(r.y0, q.y0);
+      r.x1 = max(r.x1, q.x1);
+      r.y1 = max(r.y1, q.y1);
+      rects[i] = rects[--nRects];
+      i = 0; // The bigger rectangle may now touch earlier ones
+    } else {
+      i++;
+    }
+  }
+  if (nRects == IRM_SPRITE_RECTS) {
+    // Out of slots: fold into the last one
+    Rect &q = rects[nRects - 1];
+    q.x0 = min(r.x0, q.x0);
+    q.y0 = min(r.y0, q.y0);
+    q.x1 = max(r.x1, q.x1);
+    q.y1 = max(r.y1, q.y1);
+    return;
+  }
+  rects[nRects++] = r;
+}
+
+// Stable insertion sort by z, so equal z keeps insertion order
+void IRM_SpriteLayer::sortSprites(void) {
+  IRM_Sprite *sorted = NULL;
+  while (sprites) {
+    IRM_Sprite *s = sprites;
+    sprites = s->next;
+    IRM_Sprite **p = &sorted;
+    while (*p && ((*p)->z <= s->z))
+      p = &(*p)->next;
+    s->next = *p;
+    *p = s;
+  }
+  sprites = sorted;
+}
+
+void IRM_SpriteLayer::compose(const Rect &r) {
+  uint16_t w = r.x1 - r.x0;
+  for (int16_t y = r.y0; y < r.y1; y++) {
+    if (bgBitmap) {
+      const uint16_t *bg = &bgBitmap[(uint16_t)y * matrix.width()];
+      for (int16_t x = r.x0; x < r.x1; x++)
+        row[x - r.x0] = bgProgmem ? pgm_read_word(&bg[x]) : bg[x];
+    } else {
+      for (int16_t x = r.x0; x < r.x1; x++)
+        row[x - r.x0] = bgColor;
+    }
+    for (IRM_Sprite *s = sprites; s; s = s->next) {
+      if (!s->visible || (y < s->y()) || (y >= s->y() + s->h))
+        continue;
+      int16_t x0 = max(r.x0, s->x()), x1 = min(r.x1, (int16_t)(s->x() + s->w));
+      uint16_t c;
+      for (int16_t x = x0; x < x1; x++)
+        if (s->pixel(x - s->x(), y - s->y(), c))
+          row[x - r.x0] = c;
+    }
+    for (uint16_t i = 0; i < w; i++)
+      matrix.drawPixel(r.x0 + i, y, row[i]);
+  }
+  drawn += (uint16_t)w * (r.y1 - r.y0);
+}
+
+void IRM_SpriteLayer::render(IRM_Mini &m) {
+  if (&m != &matrix) // Dirty rectangles and row belong to the bound matrix
+    return;
+  if (!row && !(row = (uint16_t *)matrix.allocBuffer(matrix.width() * 2)))
+    return;
+
+  if (full) {
+    nRects = 0;
+    addRect(0, 0, matrix.width(), matrix.height());
+    full = false;
+  } else {
+    // Where each changed sprite was, and where it is now
+    for (IRM_Sprite *s = sprites; s; s = s->next) {
+      bool on = s->visible;
+      if (!s->changed && on && s->drawnW && (s->x() == s->drawnX) &&
+          (s->y() == s->drawnY))
+        continue;
+      addRect(s->drawnX, s->drawnY, s->drawnW, s->drawnH);
+      if (on)
+        addRect(s->x(), s->y(), s->w, s->h);
+    }
+  }
+
+  sortSprites();
+  drawn = 0;
+  for (uint8_t i = 0; i < nRects; i++)
+    compose(rects[i]);
+  nRects = 0;
+
+  for (IRM_Sprite *s = sprites; s; s = s->next) {
+    s->drawnX = s->x();
+    s->drawnY = s->y();
+    s->drawnW = s->visible ? s->w : 0;
+    s->drawnH = s->visible ? s->h : 0;
+    s->changed = false;
+  }
+}
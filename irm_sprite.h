@@ -0,0 +1,209 @@
+/*!
+ * @file irm_sprite.h
+ *
+ * Sprites for IRM_Mini: bitmaps with position, velocity, z-order and
+ * transparency, redrawn only where they moved.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_SPRITE__
+#define __IRM_SPRITE__
+
+#include "irm_mini.h"
+
+#define IRM_SPRITE_RGB565 0 ///< uint16_t pixels, RGB565
+#define IRM_SPRITE_RGB888 1 ///< uint32_t pixels, 0xRRGGBB
+#define IRM_SPRITE_PAL8 2   ///< uint8_t palette indices, RGB565 palette
+
+#define IRM_SPRITE_RECTS 8 ///< Dirty rectangles tracked per frame
+
+/**
+ * @brief A bitmap placed on an IRM_SpriteLayer. Bitmaps (and palettes)
+ *        are read with pgm_read_* unless they are marked as being in RAM,
+ *        so by default they can live in PROGMEM. Positions
+ *        are whole pixels; velocities are in 1/16 pixel per second, with
+ *        sub-pixel motion accumulated between frames.
+ */
+class IRM_Sprite {
+public:
+  /**
+   * @brief  Construct a sprite.
+   * @param  bitmap   Pixels, row by row, in the given format.
+   * @param  format   IRM_SPRITE_RGB565, IRM_SPRITE_RGB888 or
+   *                  IRM_SPRITE_PAL8.
+   * @param  w        Width in pixels.
+   * @param  h        Height in pixels.
+   * @param  palette  RGB565 palette for IRM_SPRITE_PAL8.
+   * @param  progmem  true if bitmap and palette are in PROGMEM, false if
+   *                  they are in RAM.
+   */
+  IRM_Sprite(const void *bitmap, uint8_t format, uint8_t w, uint8_t h,
+             const uint16_t *palette = NULL, bool progmem = true);
+
+  /**
+   * @brief  Change the image, e.g. for animation frames.
+   * @param  bitmap   Pixels, row by row, in the given format.
+   * @param  format   Pixel format, see the constructor.
+   * @param  w        Width in pixels.
+   * @param  h        Height in pixels.
+   * @param  palette  RGB565 palette for IRM_SPRITE_PAL8.
+   * @param  progmem  true if bitmap and palette are in PROGMEM.
+   */
+  void setBitmap(const void *bitmap, uint8_t format, uint8_t w, uint8_t h,
+                 const uint16_t *palette = NULL, bool progmem = true);
+
+  /**
+   * @brief  Make pixels with this raw value see-through (a color in the
+   *         bitmap's own format, or a palette index). Sprites start with
+   *         key 0 (black or index 0) transparent.
+   * @param  key  Transparent value.
+   */
+  void setTransparent(uint32_t key);
+
+  /**
+   * @brief  Draw every pixel, with no transparency.
+   */
+  void setOpaque(void);
+
+  /**
+   * @brief  Place the sprite.
+   * @param  x  Left edge.
+   * @param  y  Top edge.
+   */
+  void moveTo(int16_t x, int16_t y);
+
+  /**
+   * @brief  Set the motion applied by IRM_SpriteLayer::update().
+   * @param  vx  Horizontal speed, 1/16 pixel per second.
+   * @param  vy  Vertical speed, 1/16 pixel per second.
+   */
+  void setVelocity(int16_t vx, int16_t vy);
+
+  /**
+   * @brief  Bounce off the display edges. A sprite bigger than the display
+   *         pans across it instead, turning when an edge comes into view.
+   * @param  on  true to bounce.
+   */
+  void setBounce(bool on) { bounce = on; }
+
+  /**
+   * @brief  Stacking order; higher z is drawn on top, and sprites with
+   *         equal z stack in the order they were added.
+   * @param  z  Depth.
+   */
+  void setZ(int8_t z);
+
+  /**
+   * @brief  Show or hide the sprite.
+   * @param  on  true to show.
+   */
+  void setVisible(bool on);
+
+  int16_t x(void) const { return fx >> 4; } ///< Left edge
+  int16_t y(void) const { return fy >> 4; } ///< Top edge
+  int16_t vx(void) const { return velX; }   ///< Horizontal speed
+  int16_t vy(void) const { return velY; }   ///< Vertical speed
+
+private:
+  friend class IRM_SpriteLayer;
+  bool pixel(int16_t sx, int16_t sy, uint16_t &color) const;
+
+  const void *bitmap;
+  const uint16_t *palette;
+  uint8_t format, w, h;
+  bool progmem;
+  int8_t z = 0;
+  bool visible = true, bounce = false, hasKey = true;
+  bool changed = true;   // Image/visibility/z changed since last drawn
+  uint32_t key = 0;
+  int32_t fx = 0, fy = 0; // Position, 1/16 pixel
+  int16_t velX = 0, velY = 0;
+  int16_t remX = 0, remY = 0; // Motion left over from the last update
+  int16_t drawnX = 0, drawnY = 0;
+  uint8_t drawnW = 0, drawnH = 0; // 0 = not on the display
+  IRM_Sprite *next = NULL;
+};
+
+/**
+ * @brief Widget that moves and draws a set of sprites over a background.
+ *        Each frame only the rectangles sprites left or entered are
+ *        recomposed, a row at a time: background, then every sprite
+ *        touching the row in z order, so each LED is written once. The
+ *        first frame (and any after invalidate()) draws everything. Sprites
+ *        are kept in an intrusive list, so adding one allocates nothing;
+ *        the only buffer is one composed row, from matrix.allocBuffer().
+ */
+class IRM_SpriteLayer : public IRM_Widget {
+public:
+  /**
+   * @brief  Bind a layer to a matrix.
+   * @param  matrix  Matrix the layer covers.
+   */
+  IRM_SpriteLayer(IRM_Mini &matrix);
+  ~IRM_SpriteLayer();
+
+  /**
+   * @brief  Add a sprite.
+   * @param  sprite  Sprite to add; must outlive the layer or be removed.
+   */
+  void add(IRM_Sprite *sprite);
+
+  /**
+   * @brief  Remove a sprite; its area is restored on the next frame.
+   * @param  sprite  Sprite to remove.
+   */
+  void remove(IRM_Sprite *sprite);
+
+  /**
+   * @brief  Solid background.
+   * @param  color  RGB565 color.
+   */
+  void setBackground(uint16_t color);
+
+  /**
+   * @brief  Bitmap background, one RGB565 pixel per display pixel.
+   * @param  bitmap   width() * height() pixels, row by row.
+   * @param  progmem  true if bitmap is in PROGMEM, false if it is in RAM.
+   */
+  void setBackground(const uint16_t *bitmap, bool progmem = true);
+
+  /**
+   * @brief  Redraw the whole display on the next frame.
+   */
+  void invalidate(void) { full = true; }
+
+  /**
+   * @brief  LEDs written by the last render(), to see the savings.
+   * @return Pixel count.
+   */
+  uint16_t pixelsDrawn(void) const { return drawn; }
+
+  void update(uint32_t dt);
+  // Only draws on the matrix the layer was bound to
+  void render(IRM_Mini &matrix);
+
+private:
+  struct Rect {
+    int16_t x0, y0, x1, y1; // Inclusive-exclusive
+  };
+
+  void addRect(int16_t x, int16_t y, int16_t w, int16_t h);
+  void sortSprites(void);
+  void compose(const Rect &r);
+
+  IRM_Mini &matrix;
+  IRM_Sprite *sprites = NULL;
+  const uint16_t *bgBitmap = NULL;
+  bool bgProgmem = true;
+  uint16_t bgColor = 0;
+  uint16_t *row = NULL; // One composed row, from matrix.allocBuffer()
+  Rect rects[IRM_SPRITE_RECTS];
+  uint8_t nRects = 0;
+  bool full = true;
+  uint16_t drawn = 0;
+};
+
+#endif // __IRM_SPRITE__
@@ -0,0 +1,206 @@
+/*!
+ * @file irm_stream.cpp
+ *
+ * Stream frame decoder for IRM_Mini, see irm_stream.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_stream.h"
+
+enum {
+  S_MAGIC0,
+  S_MAGIC1,
+  S_TYPE,
+  S_SEQ,
+  S_LEN0,
+  S_LEN1,
+  S_CTRL,
+  S_PIXELS,
+  S_CRC0,
+  S_CRC1
+};
+
+IRM_StreamDecoder::IRM_StreamDecoder(IRM_Mini &m) : matrix(m) {}
+
+// CRC-16/CCITT-FALSE, bitwise to keep flash use down on AVR
+void IRM_StreamDecoder::crcByte(uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+}
+
+void IRM_StreamDecoder::putPixel(const uint8_t *c) {
+  if (discard || (led >= matrix.numPixels()))
+    return;
+  uint16_t n = led;
+  if (type & IRM_FRAME_XY) {
+    int16_t w = matrix.width();
+    n = matrix.mapXY(led % w, led / w);
+  }
+  matrix.setPixelColor(n, c[0], c[1], c[2]);
+}
+
+// One pixel byte of a RAW payload, literal or run
+void IRM_StreamDecoder::putByte(uint8_t b) {
+  if (raw && (op == IRM_OP_LITERAL)) {
+    // Buffer already holds plain RGB: the byte goes straight in
+    if (!discard && (led < matrix.numPixels()))
+      matrix.getPixels()[led * 3 + part] = b;
+  } else {
+    rgb[part] = b;
+  }
+  if (++part < 3)
+    return;
+
+  part = 0;
+  if (op == IRM_OP_RUN) {
+    while (count--) {
+      putPixel(rgb);
+      led++;
+    }
+    count = 0;
+  } else {
+    if (!raw)
+      putPixel(rgb);
+    led++;
+    if (count)
+      count--;
+  }
+}
+
+bool IRM_StreamDecoder::poll(Stream &s) {
+  bool shown = false;
+  while (s.available() > 0)
+    shown |= feed(s.read());
+  return shown;
+}
+
+bool IRM_StreamDecoder::feed(uint8_t b) {
+  switch (state) {
+  case S_MAGIC0:
+    if (b == 'I')
+      state = S_MAGIC1;
+    else
+      counters.resyncs++;
+    return false;
+
+  case S_MAGIC1:
+    if (b == 'R') {
+      state = S_TYPE;
+      crc = 0xFFFF;
+    } else if (b != 'I') {
+      state = S_MAGIC0;
+      counters.resyncs++;
+    }
+    return false;
+
+  case S_TYPE:
+    type = b;
+    crcByte(b);
+    state = S_SEQ;
+    return false;
+
+  case S_SEQ:
+    seq = b;
+    crcByte(b);
+    state = S_LEN0;
+    return false;
+
+  case S_LEN0:
+    remaining = b;
+    crcByte(b);
+    state = S_LEN1;
+    return false;
+
+  case S_LEN1:
+    remaining |= (uint16_t)b << 8;
+    crcByte(b);
+    if ((type & 0x03) == 0x03) { // No such encoding
+      discard = true;
+      haveKey = false; // Deltas after it would build on it
+      counters.dropped++;
+    } else if ((type & 0x03) == IRM_FRAME_DELTA) {
+      // A delta can only be applied on top of the frame it was made from
+      if (haveKey && (seq != (uint8_t)(lastSeq + 1)))
+        haveKey = false;
+      discard = !haveKey;
+      if (discard)
+        counters.dropped++;
+    } else {
+      discard = false;
+    }
+    if (!matrix.getPixels()) { // Framebuffer mode: no LED buffer to write
+      if (!discard)
+        counters.dropped++;
+      discard = true;
+      haveKey = false;
+    }
+    lastSeq = seq;
+    led = 0;
+    part = count = 0;
+    raw = matrix.isRawRGB() && !(type & IRM_FRAME_XY);
+    op = IRM_OP_LITERAL;
+    if ((type & 0x03) == IRM_FRAME_RAW)
+      state = remaining ? S_PIXELS : S_CRC0;
+    else
+      state = remaining ? S_CTRL : S_CRC0;
+    return false;
+
+  case S_CTRL:
+    crcByte(b);
+    remaining--;
+    op = b & 0xC0;
+    count = (b & 0x3F) + 1;
+    if (op == IRM_OP_SKIP) {
+      if ((type & 0x03) != IRM_FRAME_DELTA)
+        discard = true; // Not valid in a key frame; CRC decides the rest
+      led += count;
+      count = 0;
+    } else if (op != IRM_OP_LITERAL && op != IRM_OP_RUN) {
+      discard = true;
+      count = 0;
+    } else {
+      state = S_PIXELS;
+    }
+    if (!remaining)
+      state = S_CRC0;
+    return false;
+
+  case S_PIXELS:
+    crcByte(b);
+    remaining--;
+    putByte(b);
+    if (!remaining)
+      state = S_CRC0;
+    else if (((type & 0x03) != IRM_FRAME_RAW) && !count && !part)
+      state = S_CTRL;
+    return false;
+
+  case S_CRC0:
+    rxCrc = b;
+    state = S_CRC1;
+    return false;
+
+  case S_CRC1:
+    rxCrc |= (uint16_t)b << 8;
+    state = S_MAGIC0;
+    if (rxCrc != crc) {
+      counters.crcErrors++;
+      haveKey = false; // Pixels may be damaged until the next key frame
+      return false;
+    }
+    if (discard)
+      return false;
+    if ((type & 0x03) != IRM_FRAME_DELTA)
+      haveKey = true;
+    matrix.markAllDirty();
+    matrix.show();
+    counters.frames++;
+    return true;
+  }
+  state = S_MAGIC0;
+  return false;
+}
@@ -0,0 +1,109 @@
+/*!
+ * @file irm_stream.h
+ *
+ * Tethered playback for IRM_Mini: frames streamed over any Arduino Stream
+ * (usually USB serial) in a small framed protocol, decoded byte by byte
+ * straight into the LED buffer. extras/irm_send.c is the host-side
+ * encoder/sender.
+ *
+ * Frame layout (multi-byte fields little-endian):
+ *
+ *   'I' 'R' | type | seq | length (2) | payload (length bytes) | CRC (2)
+ *
+ * type bits 0-1: IRM_FRAME_RAW, IRM_FRAME_RLE or IRM_FRAME_DELTA (3 is
+ * dropped); bit 7 (IRM_FRAME_XY) set means pixels are in display order
+ * rather than chain order. RAW payload is R,G,B per pixel. RLE and DELTA
+ * payloads are ops: a control byte with the op in bits 6-7 and count - 1
+ * in bits 0-5, followed by count pixels (IRM_OP_LITERAL), one pixel
+ * repeated count times (IRM_OP_RUN), or nothing (IRM_OP_SKIP, DELTA only:
+ * keep count pixels from the previous frame). The CRC is
+ * CRC-16/CCITT-FALSE over type, seq, length and payload.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_STREAM__
+#define __IRM_STREAM__
+
+#include "irm_mini.h"
+
+#define IRM_FRAME_RAW 0   ///< Uncompressed key frame
+#define IRM_FRAME_RLE 1   ///< Run-length encoded key frame
+#define IRM_FRAME_DELTA 2 ///< Changes against the previous frame
+#define IRM_FRAME_XY 0x80 ///< Pixels in display order, not chain order
+
+#define IRM_OP_LITERAL 0x00 ///< count pixels follow
+#define IRM_OP_RUN 0x40     ///< One pixel follows, repeated count times
+#define IRM_OP_SKIP 0x80    ///< Keep count pixels (DELTA frames only)
+
+/**
+ * @brief Decoder counters, see IRM_StreamDecoder::stats().
+ */
+struct IRM_StreamStats {
+  uint32_t frames;    ///< Frames shown
+  uint32_t crcErrors; ///< Frames that failed the CRC
+  uint32_t dropped;   ///< Deltas without a key frame, unknown types, or
+                      ///< no LED buffer
+  uint32_t resyncs;   ///< Bytes discarded while hunting for a frame start
+};
+
+/**
+ * @brief Incremental decoder for the IRM stream protocol. Holds only a few
+ *        bytes of state: no frame is staged anywhere but the LED buffer.
+ *        show() is called when a frame completes with a good CRC. After a
+ *        bad CRC or a sequence gap, delta frames are ignored until the
+ *        next key frame, since they'd build on damaged pixels.
+ *
+ *        Pixels are written to the LED buffer as they arrive, before the
+ *        CRC is checked. A rejected frame isn't shown by the decoder, but
+ *        its partial pixels stay in the buffer, and any other show() or
+ *        IRM_Mini::tick() in the meantime sends them.
+ */
+class IRM_StreamDecoder {
+public:
+  /**
+   * @brief  Bind a decoder to a matrix.
+   * @param  matrix  Matrix to decode into.
+   */
+  IRM_StreamDecoder(IRM_Mini &matrix);
+
+  /**
+   * @brief  Decode whatever bytes are available, without blocking.
+   * @param  s  Source stream, e.g. Serial.
+   * @return true if at least one frame was shown.
+   */
+  bool poll(Stream &s);
+
+  /**
+   * @brief  Decode one byte.
+   * @param  b  Next byte from the link.
+   * @return true if it completed a frame and show() was called.
+   */
+  bool feed(uint8_t b);
+
+  /**
+   * @brief  Decoder counters.
+   * @return Counters since construction.
+   */
+  const IRM_StreamStats &stats(void) const { return counters; }
+
+private:
+  void putByte(uint8_t b);
+  void putPixel(const uint8_t *rgb);
+  void crcByte(uint8_t b);
+
+  IRM_Mini &matrix;
+  uint8_t state = 0;
+  uint8_t type = 0, seq = 0, lastSeq = 0;
+  bool haveKey = false, discard = false, raw = false;
+  uint16_t remaining = 0; // Payload bytes left
+  uint16_t led = 0;       // Next pixel to write
+  uint8_t op = 0, count = 0, part = 0;
+  uint8_t rgb[3];
+  uint16_t crc = 0, rxCrc = 0;
+  IRM_StreamStats counters = {};
+};
+
+#endif // __IRM_STREAM__
@@ -0,0 +1,275 @@
+/*!
+ * @file irm_tables.h
+ *
+ * Lookup tables built by the compiler: gamma curves for any bit depth,
+ * exponent and peak level, fonts packed from their readable B0101 source,
+ * and sine, easing, noise and color tables for effects. Everything is
+ * evaluated with C++11 constexpr in integer fixed point, so tables are
+ * identical on every target (AVR's 32-bit double included), land in
+ * PROGMEM and cost nothing at startup.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_TABLES__
+#define __IRM_TABLES__
+
+#include <stdint.h>
+#ifdef __AVR
+#include <avr/pgmspace.h>
+#elif defined(ESP8266)
+#include <pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#endif
+
+/**
+ * @brief Compile-time list of indices 0..N-1 for table initializers.
+ */
+template <uint16_t... I> struct IRM_Seq {
+  typedef IRM_Seq type; ///< Itself, so IRM_MakeSeq can inherit it
+};
+
+/// @cond
+template <class A, class B> struct IRM_SeqJoin;
+template <uint16_t... A, uint16_t... B>
+struct IRM_SeqJoin<IRM_Seq<A...>, IRM_Seq<B...>>
+    : IRM_Seq<A..., (sizeof...(A) + B)...> {};
+/// @endcond
+
+/**
+ * @brief IRM_Seq<0, 1, ..., N - 1>, built by halving so a 512 entry table
+ *        needs only 9 levels of template recursion.
+ */
+template <uint16_t N>
+struct IRM_MakeSeq
+    : IRM_SeqJoin<typename IRM_MakeSeq<N / 2>::type,
+                  typename IRM_MakeSeq<N - N / 2>::type> {};
+/// @cond
+template <> struct IRM_MakeSeq<0> : IRM_Seq<> {};
+template <> struct IRM_MakeSeq<1> : IRM_Seq<0> {};
+/// @endcond
+
+// Fixed point math for the gamma curve, Q30 in 64 bits. C++11 constexpr
+// functions are single expressions, hence the recursion.
+#define IRM_Q 30
+#define IRM_ONE ((int64_t)1 << IRM_Q)
+#define IRM_LN2 ((int64_t)744261118) // ln(2) in Q30
+
+constexpr int64_t irmMul(int64_t a, int64_t b) {
+  return (((a >> 15) * b) + ((((a & 0x7FFF) * b)) >> 15)) >> 15;
+}
+
+// 2 * atanh(t) = ln((1 + t) / (1 - t)), t <= 1/3 so it converges quickly
+constexpr int64_t irmAtanh(int64_t t2, int64_t term, int64_t k) {
+  return (term / k == 0) ? 0 : term / k + irmAtanh(t2, irmMul(term, t2), k + 2);
+}
+
+// ln(m) for m in [1, 2), Q30
+constexpr int64_t irmLnMantissa(int64_t m) {
+  return 2 * irmAtanh(irmMul(((m - IRM_ONE) << IRM_Q) / (m + IRM_ONE),
+                             ((m - IRM_ONE) << IRM_Q) / (m + IRM_ONE)),
+                      ((m - IRM_ONE) << IRM_Q) / (m + IRM_ONE), 1);
+}
+
+// ln(n) for integer n >= 1, Q30: n = m * 2^k
+constexpr int64_t irmLn(uint32_t n, uint8_t k = 0) {
+  return ((n >> k) > 1) ? irmLn(n, k + 1)
+                        : k * IRM_LN2 + irmLnMantissa(((int64_t)n << IRM_Q) >> k);
+}
+
+// e^r for 0 <= r < ln(2), Q30, by Taylor series
+constexpr int64_t irmExpSeries(int64_t r, int64_t term, int64_t k) {
+  return (term == 0) ? 0 : term + irmExpSeries(r, irmMul(term, r) / k, k + 1);
+}
+
+// e^-y for y >= 0, Q30: y = k * ln(2) + r
+constexpr int64_t irmExpNeg(int64_t y) {
+  return (y / IRM_LN2 > 40)
+             ? 0
+             : ((IRM_ONE << IRM_Q) / irmExpSeries(y % IRM_LN2, IRM_ONE, 1)) >>
+                   (y / IRM_LN2);
+}
+
+/**
+ * @brief  One gamma table entry, rounded like extras/gamma.c.
+ * @param  i         Input level.
+ * @param  maxval    Highest input level.
+ * @param  gamma100  Exponent, in hundredths.
+ * @param  top       Output for maxval.
+ * @return round(top * (i / maxval) ^ gamma).
+ */
+constexpr uint8_t irmGammaLevel(uint16_t i, uint16_t maxval, uint16_t gamma100,
+                                uint8_t top) {
+  return (i == 0)
+             ? 0
+             : (irmExpNeg((irmLn(maxval) - irmLn(i)) * gamma100 / 100) * top +
+                IRM_ONE / 2) >>
+                   IRM_Q;
+}
+
+/// @cond
+template <uint8_t bits, uint16_t gamma100, uint8_t top, class Seq>
+struct IRM_GammaData;
+template <uint8_t bits, uint16_t gamma100, uint8_t top, uint16_t... I>
+struct IRM_GammaData<bits, gamma100, top, IRM_Seq<I...>> {
+  static const uint8_t table[sizeof...(I)];
+};
+template <uint8_t bits, uint16_t gamma100, uint8_t top, uint16_t... I>
+const uint8_t PROGMEM
+    IRM_GammaData<bits, gamma100, top, IRM_Seq<I...>>::table[sizeof...(I)] = {
+        irmGammaLevel(I, (1 << bits) - 1, gamma100, top)...};
+/// @endcond
+
+/**
+ * @brief Gamma table in PROGMEM, read with pgm_read_byte(), e.g.
+ *        IRM_Gamma<8, 220>::table. A top below 255 folds a fixed
+ *        brightness into the same lookup.
+ * @tparam bits      Input bit depth, 1-8.
+ * @tparam gamma100  Exponent, in hundredths.
+ * @tparam top       Output for the highest input.
+ */
+template <uint8_t bits, uint16_t gamma100 = 260, uint8_t top = 255>
+struct IRM_Gamma
+    : IRM_GammaData<bits, gamma100, top,
+                    typename IRM_MakeSeq<(1 << bits)>::type> {};
+
+#define IRM_PI_2 ((int64_t)1686629713) // pi / 2 in Q30
+
+// sin(x) for 0 <= x <= pi / 2, Q30, by Taylor series
+constexpr int64_t irmSinSeries(int64_t x2, int64_t term, int64_t k) {
+  return (term == 0) ? 0
+                     : term + irmSinSeries(x2, -irmMul(term, x2) / ((k + 1) *
+                                                                   (k + 2)),
+                                           k + 2);
+}
+
+// sin(q * pi / 128) for 0 <= q <= 64, Q30
+constexpr int64_t irmSinQuarter(uint8_t q) {
+  return irmSinSeries(irmMul(IRM_PI_2 * q / 64, IRM_PI_2 * q / 64),
+                      IRM_PI_2 * q / 64, 1);
+}
+
+/**
+ * @brief  One sine table entry, for a 256-step circle.
+ * @param  i  Angle, 0-255.
+ * @return round(127 * sin(i * 2 * pi / 256)).
+ */
+constexpr int8_t irmSinLevel(uint8_t i) {
+  return (i >= 128) ? -irmSinLevel(i - 128)
+                    : (irmSinQuarter((i < 64) ? i : 128 - i) * 127 +
+                       IRM_ONE / 2) >>
+                          IRM_Q;
+}
+
+/**
+ * @brief  Smoothstep, 3t^2 - 2t^3, for t = i / 256.
+ * @param  i  Input, 0-255.
+ * @return Eased value, 0-255.
+ */
+constexpr uint8_t irmEaseLevel(uint8_t i) {
+  return (uint32_t)i * i * (768 - 2 * i) >> 16;
+}
+
+/**
+ * @brief  Scrambled byte for noise lattice hashing. Odd multiplies, adds
+ *         and xors are each one-to-one on bytes, so 0-255 map to a
+ *         permutation of 0-255.
+ * @param  i  Input, 0-255.
+ * @return Permuted value.
+ */
+constexpr uint8_t irmPermLevel(uint8_t i) {
+  return (((((i * 167 + 13) & 0xFF) ^ 0xA5) * 73) + 91) & 0xFF;
+}
+
+/// @cond
+template <class Seq> struct IRM_WaveData;
+template <uint16_t... I> struct IRM_WaveData<IRM_Seq<I...>> {
+  static const int8_t sine[sizeof...(I)];
+  static const uint8_t ease[sizeof...(I)];
+  static const uint8_t perm[sizeof...(I)];
+};
+template <uint16_t... I>
+const int8_t PROGMEM IRM_WaveData<IRM_Seq<I...>>::sine[sizeof...(I)] = {
+    irmSinLevel(I)...};
+template <uint16_t... I>
+const uint8_t PROGMEM IRM_WaveData<IRM_Seq<I...>>::ease[sizeof...(I)] = {
+    irmEaseLevel(I)...};
+template <uint16_t... I>
+const uint8_t PROGMEM IRM_WaveData<IRM_Seq<I...>>::perm[sizeof...(I)] = {
+    irmPermLevel(I)...};
+/// @endcond
+
+/**
+ * @brief 256-entry PROGMEM tables for effects: sine (signed, amplitude
+ *        127), smoothstep easing and a byte permutation for noise.
+ */
+struct IRM_Wave : IRM_WaveData<IRM_MakeSeq<256>::type> {};
+
+/// @cond
+template <class Map, class Seq> struct IRM_ColorData;
+template <class Map, uint16_t... I> struct IRM_ColorData<Map, IRM_Seq<I...>> {
+  static const uint16_t colors[sizeof...(I)];
+};
+template <class Map, uint16_t... I>
+const uint16_t PROGMEM IRM_ColorData<Map, IRM_Seq<I...>>::colors[sizeof...(I)] =
+    {Map::at(I)...};
+/// @endcond
+
+/**
+ * @brief 256 '565' colors in PROGMEM, read with pgm_read_word(), from a
+ *        source providing constexpr at(i) (see IRM_HeatMap in
+ *        irm_effects.h).
+ * @tparam Map  Color source.
+ */
+template <class Map>
+struct IRM_ColorTable : IRM_ColorData<Map, IRM_MakeSeq<256>::type> {};
+
+/**
+ * @brief  Bit b of a glyph laid out as a 3-bit width then 5-bit rows.
+ * @tparam Font  Font source, see IRM_PackedFont.
+ */
+template <class Font> constexpr uint8_t irmGlyphBit(uint16_t g, uint16_t b) {
+  return (b < 3) ? (Font::at(g, 0) >> b) & 1
+         : (b < 3 + 5 * Font::rows)
+             ? (Font::at(g, 1 + (b - 3) / 5) >> ((b - 3) % 5)) & 1
+             : 0;
+}
+
+/// Byte k of a packed glyph
+template <class Font>
+constexpr uint8_t irmGlyphByte(uint16_t g, uint8_t k, uint8_t i = 0) {
+  return (i == 8) ? 0
+                  : (irmGlyphBit<Font>(g, 8 * k + i) << i) |
+                        irmGlyphByte<Font>(g, k, i + 1);
+}
+
+/// @cond
+template <class Font, class Seq> struct IRM_FontData;
+template <class Font, uint16_t... I> struct IRM_FontData<Font, IRM_Seq<I...>> {
+  static const uint8_t glyphs[sizeof...(I)];
+};
+template <class Font, uint16_t... I>
+const uint8_t PROGMEM IRM_FontData<Font, IRM_Seq<I...>>::glyphs[sizeof...(I)] =
+    {irmGlyphByte<Font>(I / Font::bytes, I % Font::bytes)...};
+/// @endcond
+
+/**
+ * @brief Font packed into PROGMEM from a readable source table. Each glyph
+ *        takes Font::bytes bytes, LSB first: width (3 bits), then each row
+ *        (5 bits, bit 0 = rightmost pixel). The source must provide
+ *        constexpr at(glyph, i) (i = 0 width, 1.. rows) and the constants
+ *        rows, count and bytes = (3 + 5 * rows + 7) / 8; it is only read
+ *        by the compiler, so it takes no flash.
+ * @tparam Font  Font source.
+ */
+template <class Font>
+struct IRM_PackedFont
+    : IRM_FontData<Font, typename IRM_MakeSeq<Font::count * Font::bytes>::type> {
+};
+
+#endif // __IRM_TABLES__
@@ -0,0 +1,217 @@
+/*!
+ * @file irm_virtual.cpp
+ *
+ * Multi-panel virtual display for IRM_Mini, see irm_virtual.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_virtual.h"
+
+IRM_VirtualDisplay::IRM_VirtualDisplay(int16_t w, int16_t h)
+    : Adafruit_GFX(w, h) {}
+
+IRM_VirtualDisplay::~IRM_VirtualDisplay() { setParallel(false); }
+
+bool IRM_VirtualDisplay::addPanel(IRM_Mini &panel, int16_t x, int16_t y,
+                                  uint8_t rot) {
+  if ((count == IRM_VIRTUAL_PANELS) || running)
+    return false;
+  panel.setRotation(rot);
+  Panel &p = panels[count++];
+  p.matrix = &panel;
+  p.x = x;
+  p.y = y;
+  p.w = panel.width();
+  p.h = panel.height();
+  p.stats = IRM_PanelStats();
+  p.owner = this;
+  p.seen = 0;
+  return true;
+}
+
+void IRM_VirtualDisplay::showPanel(Panel &p) {
+  uint32_t t0 = micros();
+  p.matrix->show();
+  p.stats.showUs = micros() - t0;
+  p.stats.maxShowUs = max(p.stats.maxShowUs, p.stats.showUs);
+  p.stats.frames++;
+}
+
+void IRM_VirtualDisplay::show(void) {
+  uint32_t t0 = micros();
+#if IRM_HAS_THREADS
+  if (running) {
+    IRM_STORE(done, 0);
+    IRM_ADD(generation, 1);
+    while (IRM_LOAD(done) < count)
+      irmSleep();
+  } else
+#endif
+  {
+    for (uint8_t i = 0; i < count; i++)
+      showPanel(panels[i]);
+  }
+  total.showUs = micros() - t0;
+  total.maxShowUs = max(total.maxShowUs, total.showUs);
+  total.frames++;
+}
+
+bool IRM_VirtualDisplay::setParallel(bool on) {
+#if IRM_HAS_THREADS
+  if (!on) {
+    stopTasks();
+    return true;
+  }
+  if (running)
+    return true;
+  running = true;
+  for (uint8_t i = 0; i < count; i++) {
+    panels[i].seen = IRM_LOAD(generation);
+    IRM_ADD(tasks, 1);
+    if (!irmStartTask(showTask, &panels[i], "irm_panel", -1)) {
+      IRM_ADD(tasks, -1);
+      stopTasks();
+      return false;
+    }
+  }
+  return true;
+#else
+  return !on;
+#endif
+}
+
+#if IRM_HAS_THREADS
+void IRM_VirtualDisplay::stopTasks(void) {
+  running = false;
+  while (IRM_LOAD(tasks))
+    irmSleep();
+}
+
+// One per panel: wait for show() to bump the generation, transmit, report
+void IRM_VirtualDisplay::showTask(void *arg) {
+  Panel *p = (Panel *)arg;
+  IRM_VirtualDisplay *d = p->owner;
+  while (d->running) {
+    uint32_t g = IRM_LOAD(d->generation);
+    if (g == p->seen) {
+      irmSleep();
+      continue;
+    }
+    p->seen = g;
+    showPanel(*p);
+    IRM_ADD(d->done, 1);
+  }
+  IRM_ADD(d->tasks, -1);
+  irmEndTask();
+}
+#endif
+
+// Clip a canvas rectangle against each panel once and hand each panel
+// its part in panel coordinates.
+void IRM_VirtualDisplay::route(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color) {
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  int16_t t;
+  switch (rotation) { // To unrotated canvas coordinates
+  case 1:
+    t = x;
+    x = WIDTH - y - h;
+    y = t;
+    t = w;
+    w = h;
+    h = t;
+    break;
+  case 2:
+    x = WIDTH - x - w;
+    y = HEIGHT - y - h;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - t - w;
+    t = w;
+    w = h;
+    h = t;
+    break;
+  }
+
+  int32_t xe = (int32_t)x + w, ye = (int32_t)y + h;
+  for (uint8_t i = 0; i < count; i++) {
+    Panel &p = panels[i];
+    int16_t x0 = max(x, p.x), y0 = max(y, p.y);
+    int16_t x1 = min(xe, (int32_t)p.x + p.w), y1 = min(ye, (int32_t)p.y + p.h);
+    if ((x0 >= x1) || (y0 >= y1))
+      continue;
+    if (y1 - y0 == 1)
+      p.matrix->drawFastHLine(x0 - p.x, y0 - p.y, x1 - x0, color);
+    else if (x1 - x0 == 1)
+      p.matrix->drawFastVLine(x0 - p.x, y0 - p.y, y1 - y0, color);
+    else
+      p.matrix->fillRect(x0 - p.x, y0 - p.y, x1 - x0, y1 - y0, color);
+  }
+}
+
+void IRM_VirtualDisplay::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return;
+
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = WIDTH - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - 1 - t;
+    break;
+  }
+
+  // Neighbouring pixels usually land on the same panel
+  for (uint8_t n = 0; n < count; n++) {
+    uint8_t i = lastHit + n;
+    if (i >= count)
+      i -= count;
+    Panel &p = panels[i];
+    if ((x >= p.x) && (y >= p.y) && (x < p.x + p.w) && (y < p.y + p.h)) {
+      lastHit = i;
+      p.matrix->drawPixel(x - p.x, y - p.y, color);
+      return;
+    }
+  }
+}
+
+void IRM_VirtualDisplay::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                       uint16_t color) {
+  route(x, y, w, 1, color);
+}
+
+void IRM_VirtualDisplay::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                       uint16_t color) {
+  route(x, y, 1, h, color);
+}
+
+void IRM_VirtualDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                  uint16_t color) {
+  route(x, y, w, h, color);
+}
+
+void IRM_VirtualDisplay::fillScreen(uint16_t color) {
+  route(0, 0, _width, _height, color);
+}
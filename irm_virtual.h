@@ -0,0 +1,122 @@
+/*!
+ * @file irm_virtual.h
+ *
+ * One Adafruit_GFX canvas spread over several IRM_Mini panels, each on its
+ * own pin (or controller), placed anywhere in the canvas.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_VIRTUAL__
+#define __IRM_VIRTUAL__
+
+#include "irm_mini.h"
+#include "irm_port.h"
+
+#define IRM_VIRTUAL_PANELS 8 ///< Most panels one virtual display can hold
+
+/**
+ * @brief Output timing for a panel, or for the whole display.
+ */
+struct IRM_PanelStats {
+  uint32_t frames;    ///< show() calls
+  uint32_t showUs;    ///< Time of the last show()
+  uint32_t maxShowUs; ///< Worst show() time
+};
+
+/**
+ * @brief Adafruit_GFX canvas made of several IRM_Mini panels. Pixels,
+ *        lines and rectangles are clipped once per primitive against each
+ *        panel they overlap and passed on in panel coordinates, so panels
+ *        never see off-panel drawing. Areas no panel covers are dropped.
+ */
+class IRM_VirtualDisplay : public Adafruit_GFX {
+public:
+  /**
+   * @brief  Construct an empty canvas.
+   * @param  w  Canvas width.
+   * @param  h  Canvas height.
+   */
+  IRM_VirtualDisplay(int16_t w, int16_t h);
+  ~IRM_VirtualDisplay();
+
+  /**
+   * @brief  Place a panel on the canvas. The panel is rotated with its
+   *         own setRotation(), so its width()/height() are as placed.
+   * @param  panel     Panel, already begin()'d.
+   * @param  x         Canvas column of the panel's left edge.
+   * @param  y         Canvas row of the panel's top edge.
+   * @param  rotation  Panel rotation, 0-3.
+   * @return false if IRM_VIRTUAL_PANELS are already placed.
+   */
+  bool addPanel(IRM_Mini &panel, int16_t x, int16_t y, uint8_t rotation = 0);
+
+  /**
+   * @brief  Choose how show() drives the panels.
+   * @param  on  true: one task per panel, all transmitting at once, with
+   *             show() returning when every panel is done. false: one
+   *             after another on the calling task.
+   * @return false if this board has no tasks (see irm_port.h) or a task
+   *         couldn't be started; show() then stays sequential.
+   */
+  bool setParallel(bool on);
+
+  /**
+   * @brief  Latch the frame on every panel.
+   */
+  void show(void);
+
+  /**
+   * @brief  Timing of one panel's show().
+   * @param  i  Panel index, in addPanel() order.
+   * @return Panel stats.
+   */
+  const IRM_PanelStats &panelStats(uint8_t i) const { return panels[i].stats; }
+
+  /**
+   * @brief  Timing of the whole show().
+   * @return Display stats.
+   */
+  const IRM_PanelStats &stats(void) const { return total; }
+
+  /**
+   * @brief  Number of panels placed.
+   * @return Panel count.
+   */
+  uint8_t panelCount(void) const { return count; }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillScreen(uint16_t color);
+
+private:
+  struct Panel {
+    IRM_Mini *matrix;
+    int16_t x, y, w, h; // Canvas area covered
+    IRM_PanelStats stats;
+    IRM_VirtualDisplay *owner;
+    uint32_t seen;      // Last show generation handled (parallel mode)
+  };
+
+  void route(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  static void showPanel(Panel &p);
+#if IRM_HAS_THREADS
+  static void showTask(void *arg);
+  void stopTasks(void);
+#endif
+
+  Panel panels[IRM_VIRTUAL_PANELS];
+  uint8_t count = 0;
+  uint8_t lastHit = 0; // Panel the previous pixel landed on
+  IRM_PanelStats total = {};
+  bool parallel = false;
+  volatile bool running = false;
+  uint32_t generation = 0, done = 0; // Via IRM_LOAD/IRM_STORE
+  uint8_t tasks = 0;
+};
+
+#endif // __IRM_VIRTUAL__
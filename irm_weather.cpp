@@ -0,0 +1,102 @@
+/*!
+ * @file irm_weather.cpp
+ *
+ * Weather widget for IRM_Mini, see irm_weather.h.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#include "irm_weather.h"
+
+// OpenWeatherMap icon numbers, in icon table order (day, night pairs)
+static const uint8_t PROGMEM ICON_CODES[] = {1, 2, 3, 4, 9, 10, 11, 13, 50};
+
+void IRM_WeatherWidget::begin(void) {
+  reset();
+  haveIcon = false;
+}
+
+void IRM_WeatherWidget::setIcons(const uint32_t *bitmaps, uint8_t w,
+                                 uint8_t h) {
+  icons = bitmaps;
+  iconW = w;
+  iconH = h;
+  changed = true;
+}
+
+void IRM_WeatherWidget::setPosition(int16_t x, int16_t y, uint16_t color,
+                                    uint16_t bg, uint8_t fontSize) {
+  posX = x;
+  posY = y;
+  textColor = color;
+  bgColor = bg;
+  font = fontSize;
+  changed = true;
+}
+
+int8_t IRM_WeatherWidget::iconIndex(const char *code) {
+  if (!isdigit(code[0]) || !isdigit(code[1]))
+    return -1;
+  uint8_t n = (code[0] - '0') * 10 + (code[1] - '0');
+  bool night = (code[2] == 'n') || (code[2] == 'N');
+  for (uint8_t i = 0; i < sizeof(ICON_CODES); i++) {
+    if (pgm_read_byte(&ICON_CODES[i]) == n) {
+      int8_t idx = i * 2 + night;
+      return min(idx, (int8_t)(IRM_WEATHER_ICONS - 1)); // No 50n icon
+    }
+  }
+  return -1;
+}
+
+void IRM_WeatherWidget::onValue(const char *value, bool isString) {
+  // {"weather":[{"icon":"01d",...},...],"main":{"temp":21.37,...},...}
+  if ((depth() == 2) && !strcmp(key(), "temp") && !strcmp(key(1), "main")) {
+    int16_t t = toFixed(value, 1);
+    changed |= !haveTemp || (t != temp);
+    temp = t;
+    haveTemp = true;
+  } else if (isString && !haveIcon && (depth() == 3) &&
+             !strcmp(key(), "icon") && !strcmp(key(2), "weather")) {
+    int8_t idx = iconIndex(value);
+    if ((idx >= 0) && (idx != iconIdx)) {
+      iconIdx = idx;
+      changed = true;
+    }
+    haveIcon = true; // Later entries are secondary conditions
+  }
+}
+
+void IRM_WeatherWidget::render(IRM_Mini &matrix) {
+  if (!changed)
+    return;
+  changed = false;
+  if (icons && (iconIdx >= 0)) {
+    matrix.fillRect(posX, posY, iconW, iconH, bgColor);
+    matrix.drawRGBBitmap(posX, posY, icons + (uint16_t)iconIdx * iconW * iconH,
+                         iconW, iconH);
+  }
+  if (!haveTemp)
+    return;
+
+  char text[8];
+  snprintf(text, sizeof(text), "%d", (temp + (temp < 0 ? -5 : 5)) / 10);
+  int16_t x = posX + iconW + 1;
+  int16_t y = posY + ((iconH > font) ? (iconH - font) / 2 : 0);
+  // Glyphs are drawn here over bgColor; drawAscii() puts each on black
+  uint8_t rows[FONT7];
+  uint8_t w = 0;
+  for (uint8_t i = 0; text[i]; i++)
+    w += IRM_Mini::glyph(text[i], font, rows) + 1;
+  matrix.fillRect(x, y, max(w, textW), font, bgColor); // "-10" may become "9"
+  textW = w;
+  for (uint8_t i = 0; text[i]; i++) {
+    uint8_t width = IRM_Mini::glyph(text[i], font, rows);
+    for (uint8_t j = 0; j < font; j++)
+      for (uint8_t k = 0; k < width; k++)
+        if (rows[j] & (1 << k))
+          matrix.drawPixel(x + width - k - 1, y + j, textColor);
+    x += width + 1;
+  }
+}
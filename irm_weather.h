@@ -0,0 +1,107 @@
+/*!
+ * @file irm_weather.h
+ *
+ * Weather widget for IRM_Mini: pulls the temperature and icon code out of
+ * an OpenWeatherMap "current weather" response as it streams in, and draws
+ * them.
+ *
+ * This file is part of the IRM Mini library, a fork of the Adafruit
+ * NeoMatrix library, under the GNU Lesser General Public License.
+ *
+ */
+
+#ifndef __IRM_WEATHER__
+#define __IRM_WEATHER__
+
+#include "irm_json.h"
+#include "irm_mini.h"
+
+#define IRM_WEATHER_ICONS 17 ///< Icons in the OpenWeatherMap set (01d..50d)
+
+/**
+ * @brief OpenWeatherMap widget. Feed it the response body (e.g.
+ *        http.writeToStream(&weather)) and register it with
+ *        IRM_Mini::addWidget(); it draws the icon for the current
+ *        conditions with the temperature to its right, whenever they
+ *        change. Only main.temp and weather[0].icon are kept; the rest of
+ *        the body is scanned and dropped.
+ */
+class IRM_WeatherWidget : public IRM_JsonScanner, public IRM_Widget {
+public:
+  /**
+   * @brief  Start a new response. Values from the previous one are kept
+   *         until the new one supplies them.
+   */
+  void begin(void);
+
+  /**
+   * @brief  Set the icon bitmaps, in IRM_WEATHER_ICONS order: 01d, 01n,
+   *         02d, 02n, 03d, 03n, 04d, 04n, 09d, 09n, 10d, 10n, 11d, 11n,
+   *         13d, 13n, 50d.
+   * @param  icons  w * h 24-bit RGB pixels per icon, icons back to back.
+   * @param  w      Icon width.
+   * @param  h      Icon height.
+   */
+  void setIcons(const uint32_t *icons, uint8_t w, uint8_t h);
+
+  /**
+   * @brief  Where to draw, and in what style.
+   * @param  x         Left edge of the icon.
+   * @param  y         Top edge of the icon.
+   * @param  color     Temperature text color.
+   * @param  bg        Background behind the icon and text.
+   * @param  fontSize  FONT5 or FONT7.
+   */
+  void setPosition(int16_t x, int16_t y, uint16_t color = 0xFFFF,
+                   uint16_t bg = 0, uint8_t fontSize = FONT5);
+
+  /**
+   * @brief  Map an OpenWeatherMap icon code to its icon index.
+   * @param  code  Icon code, e.g. "10n" (either case).
+   * @return Index into the setIcons() table, or -1 if unknown.
+   */
+  static int8_t iconIndex(const char *code);
+
+  /**
+   * @brief  Whether a temperature has been received.
+   * @return true once main.temp has been seen.
+   */
+  bool valid(void) const { return haveTemp; }
+
+  /**
+   * @brief  Last temperature received.
+   * @return Tenths of a degree, in the units the request asked for.
+   */
+  int16_t temperature(void) const { return temp; }
+
+  /**
+   * @brief  Last icon received.
+   * @return Icon index, or -1 if none yet.
+   */
+  int8_t icon(void) const { return iconIdx; }
+
+  /**
+   * @brief  Redraw on the next frame even if nothing changed.
+   */
+  void invalidate(void) { changed = true; }
+
+  void render(IRM_Mini &matrix);
+
+protected:
+  void onValue(const char *value, bool isString);
+
+private:
+  const uint32_t *icons = NULL;
+  uint8_t iconW = 0, iconH = 0;
+  int16_t posX = 0, posY = 0;
+  uint16_t textColor = 0xFFFF, bgColor = 0;
+  uint8_t textW = 0; // Width of the text last drawn
+  uint8_t font = FONT5;
+  int16_t temp = 0;
+  int8_t iconIdx = -1;
+  bool haveTemp = false;
+  bool haveIcon = false; // weather[0] seen in this response
+  bool changed = false;  // Needs drawing
+};
+
+#endif // __IRM_WEATHER__